@@ -31,6 +31,8 @@
 CERES_SRCS = ["internal/ceres/" + filename for filename in [
     "accelerate_sparse.cc",
     "array_utils.cc",
+    "batch_cost_function.cc",
+    "block_arena.cc",
     "block_evaluate_preparer.cc",
     "block_jacobi_preconditioner.cc",
     "block_jacobian_writer.cc",
@@ -98,6 +100,7 @@ CERES_SRCS = ["internal/ceres/" + filename for filename in [
     "parallel_invoke.cc",
     "parallel_utils.cc",
     "parallel_vector_ops.cc",
+    "parameter_block_aliasing.cc",
     "parameter_block_ordering.cc",
     "partitioned_matrix_view.cc",
     "polynomial.cc",
@@ -109,6 +112,7 @@ CERES_SRCS = ["internal/ceres/" + filename for filename in [
     "program.cc",
     "reorder_program.cc",
     "residual_block.cc",
+    "residual_block_batch.cc",
     "residual_block_utils.cc",
     "schur_complement_solver.cc",
     "schur_eliminator.cc",
@@ -116,7 +120,10 @@ CERES_SRCS = ["internal/ceres/" + filename for filename in [
     "schur_templates.cc",
     "scratch_evaluate_preparer.cc",
     "single_linkage_clustering.cc",
+    "small_blas_simd.cc",
     "solver.cc",
+    "solver_plan.cc",
+    "solver_plan_impl.cc",
     "solver_utils.cc",
     "sparse_cholesky.cc",
     "sparse_matrix.cc",
@@ -0,0 +1,392 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// A BatchCostFunction with Jacobians computed via automatic differentiation,
+// which evaluates several residual blocks at once in the lanes of SIMD
+// registers.
+//
+// AutoDiffCostFunction evaluates one residual block with Jet<double, N>, so
+// the vector units are only used along the N derivatives, and for small N,
+// e.g., the 12 of a bundle adjustment reprojection error, they mostly sit
+// idle. AutoDiffBatchCostFunction evaluates the functor with a Jet whose
+// scalar holds one value per residual block of a batch, so each arithmetic
+// operation of the functor is carried out for several residual blocks with
+// the same instructions.
+//
+// The functor is written as for AutoDiffCostFunction, with one difference:
+// the data which differs between residual blocks, e.g., the observation of a
+// reprojection error, cannot be stored in the functor, since all the lanes of
+// a batch are evaluated by the same functor object. Instead, the functor
+// declares the number of such values as kNumData, and receives them as an
+// array of their own scalar type S ahead of the parameter blocks:
+//
+//   struct ReprojectionError {
+//     static constexpr int kNumData = 2;
+//
+//     template <typename S, typename T>
+//     bool operator()(const S* observation,
+//                     const T* camera,
+//                     const T* point,
+//                     T* residuals) const {
+//       ...
+//       residuals[0] = predicted_x - observation[0];
+//       residuals[1] = predicted_y - observation[1];
+//       return true;
+//     }
+//   };
+//
+// The values are given to the constructor of each residual block's cost
+// function:
+//
+//   CostFunction* cost_function =
+//       new AutoDiffBatchCostFunction<ReprojectionError, 2, 9, 3>(
+//           observed_x, observed_y);
+//
+// A functor without kNumData has no per residual block data, and is called
+// with the parameter blocks and the residuals only. The functor is default
+// constructed; any members it has must be the same for all residual blocks.
+//
+// If a comparison or a classification in the functor does not have the same
+// result for all the residual blocks in the lanes, e.g., because the branch
+// of AngleAxisRotatePoint for small angles is taken for some of them only,
+// the residual blocks are evaluated again, one by one, with Jet<double, N>.
+// The results are thus always those of a scalar evaluation, but a functor
+// whose branches often diverge gains nothing from batching.
+//
+// The gain is largest for functors with few parameters and a lot of scalar
+// work per residual block, e.g., rotations, divisions and square roots. For
+// functors with many parameters the derivatives dominate, and these are
+// already vectorized by Jet<double, N>; functors calling functions which
+// Lanes applies lane by lane, e.g., pow or atan2, may even be slower.
+//
+// Residual blocks are only batched when all the blocks of a problem are
+// evaluated, e.g., by Solver::Solve, see BatchCostFunction. Evaluated on its
+// own, e.g., by Problem::EvaluateResidualBlock, the cost function uses
+// Jet<double, N> like AutoDiffCostFunction.
+
+#ifndef CERES_PUBLIC_AUTODIFF_BATCH_COST_FUNCTION_H_
+#define CERES_PUBLIC_AUTODIFF_BATCH_COST_FUNCTION_H_
+
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "ceres/batch_cost_function.h"
+#include "ceres/internal/lanes.h"
+#include "ceres/internal/parameter_dims.h"
+#include "ceres/jet.h"
+#include "ceres/types.h"
+
+namespace ceres {
+
+namespace internal {
+
+// The number of values of per residual block data of a functor, which is
+// CostFunctor::kNumData if it is declared and zero otherwise.
+template <typename CostFunctor, typename = void>
+struct NumCostFunctorData : std::integral_constant<int, 0> {};
+
+template <typename CostFunctor>
+struct NumCostFunctorData<CostFunctor,
+                          std::void_t<decltype(CostFunctor::kNumData)>>
+    : std::integral_constant<int, CostFunctor::kNumData> {};
+
+}  // namespace internal
+
+template <typename CostFunctor,
+          int kNumResiduals,  // Number of residuals.
+          int... Ns>          // Number of parameters in each parameter block.
+class AutoDiffBatchCostFunction final : public BatchCostFunction {
+ public:
+  static constexpr int kNumData = internal::NumCostFunctorData<CostFunctor>();
+
+  // Takes the kNumData values of the per residual block data.
+  template <typename... Data>
+  explicit AutoDiffBatchCostFunction(Data... data)
+      : data_{{static_cast<double>(data)...}} {
+    static_assert(sizeof...(Data) == kNumData,
+                  "The number of values passed to the constructor must be "
+                  "the functor's kNumData.");
+    set_num_residuals(kNumResiduals);
+    *mutable_parameter_block_sizes() = {Ns...};
+  }
+
+  bool EvaluateBatch(int batch_size,
+                     const BatchCostFunction* const* cost_functions,
+                     double const* const* parameters,
+                     double* residuals,
+                     double** jacobians) const override {
+    for (int start = 0; start < batch_size; start += kNumLanes) {
+      if (!EvaluateLanes(start,
+                         std::min(kNumLanes, batch_size - start),
+                         batch_size,
+                         cost_functions,
+                         parameters,
+                         residuals,
+                         jacobians)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  bool Evaluate(double const* const* parameters,
+                double* residuals,
+                double** jacobians) const override {
+    const BatchCostFunction* self = this;
+    return EvaluateLane(0, 1, &self, parameters, residuals, jacobians);
+  }
+
+  const std::array<double, kNumData>& data() const { return data_; }
+
+ private:
+  using ParameterDims = internal::StaticParameterDims<Ns...>;
+  static constexpr int kNumLanes = internal::kNumSimdLanes;
+  static constexpr int kNumParameters = ParameterDims::kNumParameters;
+  static constexpr int kNumParameterBlocks = ParameterDims::kNumParameterBlocks;
+  static constexpr std::array<int, kNumParameterBlocks> kBlockSizes{Ns...};
+  static_assert(kNumResiduals > 0,
+                "The number of residuals must be known at compile time.");
+
+  // Evaluates the num_lanes residual blocks of a batch of batch_size residual
+  // blocks starting at start, in the lanes of a Jet<Lanes, kNumParameters>.
+  // If the lanes diverge, they are evaluated again one by one.
+  bool EvaluateLanes(int start,
+                     int num_lanes,
+                     int batch_size,
+                     const BatchCostFunction* const* cost_functions,
+                     double const* const* parameters,
+                     double* residuals,
+                     double** jacobians) const {
+    using Lanes = internal::Lanes<kNumLanes>;
+    // In the structure of arrays layout of the batch, the values of the
+    // residual blocks evaluated together are next to each other. Unused lanes
+    // repeat the last residual block.
+    auto load = [num_lanes](const double* values) {
+      if (num_lanes == kNumLanes) {
+        return Lanes::Load(values);
+      }
+      Lanes x;
+      for (int lane = 0; lane < kNumLanes; ++lane) {
+        x[lane] = values[std::min(lane, num_lanes - 1)];
+      }
+      return x;
+    };
+    auto store = [num_lanes](const Lanes& x, double* values) {
+      if (num_lanes == kNumLanes) {
+        x.Store(values);
+        return;
+      }
+      for (int lane = 0; lane < num_lanes; ++lane) {
+        values[lane] = x[lane];
+      }
+    };
+
+    std::array<Lanes, kNumData> data;
+    for (int lane = 0; lane < kNumLanes; ++lane) {
+      const auto& lane_data =
+          Data(cost_functions[start + std::min(lane, num_lanes - 1)]);
+      for (int i = 0; i < kNumData; ++i) {
+        data[i][lane] = lane_data[i];
+      }
+    }
+
+    internal::LanesDiverged() = false;
+    bool success;
+    if (jacobians == nullptr) {
+      Lanes x[kNumParameters];
+      int offset = 0;
+      for (int b = 0; b < kNumParameterBlocks; ++b) {
+        for (int j = 0; j < kBlockSizes[b]; ++j) {
+          x[offset + j] = load(parameters[b] + j * batch_size + start);
+        }
+        offset += kBlockSizes[b];
+      }
+      Lanes r[kNumResiduals];
+      success = Call(data.data(), x, r);
+      if (!internal::LanesDiverged()) {
+        for (int i = 0; i < kNumResiduals; ++i) {
+          store(r[i], residuals + i * batch_size + start);
+        }
+        return success;
+      }
+    } else {
+      using JetT = Jet<Lanes, kNumParameters>;
+      JetT x[kNumParameters];
+      int offset = 0;
+      for (int b = 0; b < kNumParameterBlocks; ++b) {
+        for (int j = 0; j < kBlockSizes[b]; ++j) {
+          x[offset + j].a = load(parameters[b] + j * batch_size + start);
+          x[offset + j].v[offset + j] = Lanes(1.0);
+        }
+        offset += kBlockSizes[b];
+      }
+      JetT r[kNumResiduals];
+      success = Call(data.data(), x, r);
+      if (!internal::LanesDiverged()) {
+        for (int i = 0; i < kNumResiduals; ++i) {
+          store(r[i].a, residuals + i * batch_size + start);
+        }
+        offset = 0;
+        for (int b = 0; b < kNumParameterBlocks; ++b) {
+          const int block_size = kBlockSizes[b];
+          if (jacobians[b] != nullptr) {
+            for (int i = 0; i < kNumResiduals; ++i) {
+              for (int j = 0; j < block_size; ++j) {
+                store(r[i].v[offset + j],
+                      jacobians[b] + (i * block_size + j) * batch_size + start);
+              }
+            }
+          }
+          offset += block_size;
+        }
+        return success;
+      }
+    }
+
+    for (int lane = 0; lane < num_lanes; ++lane) {
+      if (!EvaluateLane(start + lane,
+                        batch_size,
+                        cost_functions,
+                        parameters,
+                        residuals,
+                        jacobians)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // Evaluates residual block k of a batch of batch_size residual blocks on
+  // its own, with doubles or Jet<double, kNumParameters>.
+  bool EvaluateLane(int k,
+                    int batch_size,
+                    const BatchCostFunction* const* cost_functions,
+                    double const* const* parameters,
+                    double* residuals,
+                    double** jacobians) const {
+    const double* data = Data(cost_functions[k]).data();
+    if (jacobians == nullptr) {
+      double x[kNumParameters];
+      double r[kNumResiduals];
+      GatherLane(parameters, k, batch_size, x);
+      if (!Call(data, x, r)) {
+        return false;
+      }
+      for (int i = 0; i < kNumResiduals; ++i) {
+        residuals[i * batch_size + k] = r[i];
+      }
+      return true;
+    }
+
+    using JetT = Jet<double, kNumParameters>;
+    JetT x[kNumParameters];
+    JetT r[kNumResiduals];
+    GatherLane(parameters, k, batch_size, x);
+    for (int j = 0; j < kNumParameters; ++j) {
+      x[j].v[j] = 1.0;
+    }
+    if (!Call(data, x, r)) {
+      return false;
+    }
+    for (int i = 0; i < kNumResiduals; ++i) {
+      residuals[i * batch_size + k] = r[i].a;
+    }
+    int offset = 0;
+    for (int b = 0; b < kNumParameterBlocks; ++b) {
+      const int block_size = kBlockSizes[b];
+      if (jacobians[b] != nullptr) {
+        for (int i = 0; i < kNumResiduals; ++i) {
+          for (int j = 0; j < block_size; ++j) {
+            jacobians[b][(i * block_size + j) * batch_size + k] =
+                r[i].v[offset + j];
+          }
+        }
+      }
+      offset += block_size;
+    }
+    return true;
+  }
+
+  // Copies the parameters of residual block k of a batch of batch_size
+  // residual blocks into x, a packed array of kNumParameters values.
+  static void GatherLane(double const* const* parameters,
+                         int k,
+                         int batch_size,
+                         double* x) {
+    int offset = 0;
+    for (int b = 0; b < kNumParameterBlocks; ++b) {
+      for (int j = 0; j < kBlockSizes[b]; ++j) {
+        x[offset + j] = parameters[b][j * batch_size + k];
+      }
+      offset += kBlockSizes[b];
+    }
+  }
+
+  template <typename T>
+  static void GatherLane(double const* const* parameters,
+                         int k,
+                         int batch_size,
+                         T* x) {
+    double values[kNumParameters];
+    GatherLane(parameters, k, batch_size, values);
+    for (int j = 0; j < kNumParameters; ++j) {
+      x[j] = T(values[j]);
+    }
+  }
+
+  template <typename S, typename T>
+  bool Call(const S* data, const T* x, T* residuals) const {
+    const auto blocks = ParameterDims::GetUnpackedParameters(x);
+    return std::apply(
+        [&](auto... block) {
+          if constexpr (kNumData == 0) {
+            return static_cast<bool>(functor_(block..., residuals));
+          } else {
+            return static_cast<bool>(functor_(data, block..., residuals));
+          }
+        },
+        blocks);
+  }
+
+  static const std::array<double, kNumData>& Data(
+      const BatchCostFunction* cost_function) {
+    return static_cast<const AutoDiffBatchCostFunction*>(cost_function)
+        ->data_;
+  }
+
+  CostFunctor functor_;
+  std::array<double, kNumData> data_;
+};
+
+}  // namespace ceres
+
+#endif  // CERES_PUBLIC_AUTODIFF_BATCH_COST_FUNCTION_H_
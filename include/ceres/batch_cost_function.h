@@ -0,0 +1,97 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// A BatchCostFunction is a CostFunction that can evaluate many residual
+// blocks of the same kind with a single call. When all the residual blocks of
+// a problem are evaluated, e.g., by Solver::Solve, the residual blocks whose
+// cost functions are BatchCostFunctions of the same type and shape are grouped
+// into batches and evaluated together with EvaluateBatch. This amortizes the
+// virtual call and lets the implementation vectorize across residual blocks.
+
+#ifndef CERES_PUBLIC_BATCH_COST_FUNCTION_H_
+#define CERES_PUBLIC_BATCH_COST_FUNCTION_H_
+
+#include "ceres/cost_function.h"
+#include "ceres/internal/disable_warnings.h"
+#include "ceres/internal/export.h"
+
+namespace ceres {
+
+class CERES_EXPORT BatchCostFunction : public CostFunction {
+ public:
+  BatchCostFunction();
+  ~BatchCostFunction() override;
+
+  // Evaluates batch_size residual blocks. cost_functions[k] is the cost
+  // function of the k'th residual block of the batch; all of them have the
+  // same dynamic type, number of residuals and parameter block sizes as this
+  // object, which is one of them. Implementations read any per residual block
+  // data, e.g., the observation of a reprojection error, from cost_functions.
+  //
+  // The inputs and outputs are stored in structure of arrays layout, i.e.,
+  // the values of the residual blocks of the batch are interleaved:
+  //
+  //   parameters[i][j * batch_size + k] = parameter j of block i of residual
+  //                                       block k
+  //
+  //   residuals[r * batch_size + k] = residual r of residual block k
+  //
+  //   jacobians[i][(r * parameter_block_sizes()[i] + c) * batch_size + k] =
+  //     d residual[r] / d parameters[i][c] of residual block k
+  //
+  // As with CostFunction::Evaluate, if jacobians is nullptr no derivatives are
+  // computed, and if jacobians[i] is nullptr the jacobian of the i'th
+  // parameter block must not be written. The return value indicates whether
+  // the evaluation of all the residual blocks in the batch succeeded.
+  virtual bool EvaluateBatch(int batch_size,
+                             const BatchCostFunction* const* cost_functions,
+                             double const* const* parameters,
+                             double* residuals,
+                             double** jacobians) const = 0;
+
+  // Evaluates this cost function alone, as a batch of size one.
+  bool Evaluate(double const* const* parameters,
+                double* residuals,
+                double** jacobians) const override;
+
+  // The largest number of residual blocks passed to a single call of
+  // EvaluateBatch.
+  int max_batch_size() const { return max_batch_size_; }
+
+ protected:
+  void set_max_batch_size(int max_batch_size);
+
+ private:
+  int max_batch_size_;
+};
+
+}  // namespace ceres
+
+#include "ceres/internal/reenable_warnings.h"
+
+#endif  // CERES_PUBLIC_BATCH_COST_FUNCTION_H_
@@ -35,9 +35,11 @@
 #define CERES_PUBLIC_CERES_H_
 
 // IWYU pragma: begin_exports
+#include "ceres/autodiff_batch_cost_function.h"
 #include "ceres/autodiff_cost_function.h"
 #include "ceres/autodiff_first_order_function.h"
 #include "ceres/autodiff_manifold.h"
+#include "ceres/batch_cost_function.h"
 #include "ceres/conditioned_cost_function.h"
 #include "ceres/constants.h"
 #include "ceres/context.h"
@@ -67,6 +69,7 @@
 #include "ceres/product_manifold.h"
 #include "ceres/sized_cost_function.h"
 #include "ceres/solver.h"
+#include "ceres/solver_plan.h"
 #include "ceres/sphere_manifold.h"
 #include "ceres/types.h"
 #include "ceres/version.h"
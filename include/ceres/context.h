@@ -43,6 +43,19 @@ namespace ceres {
 // (e.g. threads) managed by the Context.
 class CERES_EXPORT Context {
  public:
+  struct CERES_EXPORT Options {
+    // If true, every worker thread of the thread pool is pinned to a single
+    // CPU. CPUs are assigned in order of their NUMA node, so workers fill up
+    // one node before moving on to the next one. Together with the parallel
+    // first-touch initialization of the large buffers used by Ceres, this
+    // spreads the memory of the problem across the NUMA nodes of the threads
+    // which use it.
+    //
+    // Thread pinning is currently only supported on Linux, on other platforms
+    // this option is ignored.
+    bool pin_threads = false;
+  };
+
   Context();
   Context(const Context&) = delete;
   void operator=(const Context&) = delete;
@@ -51,6 +64,7 @@ class CERES_EXPORT Context {
 
   // Creates a context object and the caller takes ownership.
   static Context* Create();
+  static Context* Create(const Options& options);
 };
 
 }  // namespace ceres
@@ -0,0 +1,358 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// A scalar type holding one double per residual block of a batch, used by
+// AutoDiffBatchCostFunction to evaluate several residual blocks in the lanes
+// of SIMD registers. Jet<Lanes<kNumLanes>, N> carries the values and the
+// derivatives of kNumLanes residual blocks at once.
+
+#ifndef CERES_PUBLIC_INTERNAL_LANES_H_
+#define CERES_PUBLIC_INTERNAL_LANES_H_
+
+#include <cmath>
+#include <limits>
+#include <ostream>
+
+#include "Eigen/Core"
+
+namespace ceres {
+namespace internal {
+
+// The number of lanes which fills a SIMD register of the target, e.g., 2 for
+// SSE2 and NEON, and 4 for AVX.
+inline constexpr int kNumSimdLanes =
+    EIGEN_MAX_STATIC_ALIGN_BYTES / static_cast<int>(sizeof(double)) > 2
+        ? EIGEN_MAX_STATIC_ALIGN_BYTES / static_cast<int>(sizeof(double))
+        : 2;
+
+// Set when a comparison or a classification of a Lanes value does not have
+// the same result in all lanes, i.e., when the residual blocks evaluated in
+// the lanes would take different branches. The result of such an evaluation
+// is meaningless, and the residual blocks have to be evaluated one by one.
+inline bool& LanesDiverged() {
+  static thread_local bool diverged = false;
+  return diverged;
+}
+
+template <int kNumLanes>
+class Lanes {
+ public:
+  using Array = Eigen::Array<double, kNumLanes, 1>;
+
+  // The values are a plain array operated on lane by lane, which the compiler
+  // vectorizes and, unlike Eigen expressions, reliably inlines into the large
+  // functions autodiff produces.
+  Lanes() {
+    for (int i = 0; i < kNumLanes; ++i) {
+      values_[i] = 0.0;
+    }
+  }
+  // Broadcasts value to all the lanes. The conversion is implicit, as for
+  // double, so that constants mix with Lanes in arithmetic.
+  Lanes(double value) {  // NOLINT
+    for (int i = 0; i < kNumLanes; ++i) {
+      values_[i] = value;
+    }
+  }
+  template <typename Derived>
+  explicit Lanes(const Eigen::ArrayBase<Derived>& values) {
+    Eigen::Map<Array> destination(values_);
+    destination = values;
+  }
+
+  // Loads and stores kNumLanes consecutive values.
+  static Lanes Load(const double* values) {
+    Lanes x;
+    for (int i = 0; i < kNumLanes; ++i) {
+      x.values_[i] = values[i];
+    }
+    return x;
+  }
+  void Store(double* values) const {
+    for (int i = 0; i < kNumLanes; ++i) {
+      values[i] = values_[i];
+    }
+  }
+
+  double operator[](int lane) const { return values_[lane]; }
+  double& operator[](int lane) { return values_[lane]; }
+
+  Lanes& operator+=(const Lanes& y) {
+    return Apply(y, [](double& a, double b) { a += b; });
+  }
+  Lanes& operator-=(const Lanes& y) {
+    return Apply(y, [](double& a, double b) { a -= b; });
+  }
+  Lanes& operator*=(const Lanes& y) {
+    return Apply(y, [](double& a, double b) { a *= b; });
+  }
+  Lanes& operator/=(const Lanes& y) {
+    return Apply(y, [](double& a, double b) { a /= b; });
+  }
+
+  friend Lanes operator+(const Lanes& x) { return x; }
+  friend Lanes operator-(const Lanes& x) {
+    return x.Map([](double a) { return -a; });
+  }
+  friend Lanes operator+(Lanes x, const Lanes& y) { return x += y; }
+  friend Lanes operator-(Lanes x, const Lanes& y) { return x -= y; }
+  friend Lanes operator*(Lanes x, const Lanes& y) { return x *= y; }
+  friend Lanes operator/(Lanes x, const Lanes& y) { return x /= y; }
+
+  // Comparisons are true if they hold in all lanes, see LanesDiverged.
+  friend bool operator<(const Lanes& x, const Lanes& y) {
+    return x.AllLanes(y, [](double a, double b) { return a < b; });
+  }
+  friend bool operator<=(const Lanes& x, const Lanes& y) {
+    return x.AllLanes(y, [](double a, double b) { return a <= b; });
+  }
+  friend bool operator>(const Lanes& x, const Lanes& y) {
+    return x.AllLanes(y, [](double a, double b) { return a > b; });
+  }
+  friend bool operator>=(const Lanes& x, const Lanes& y) {
+    return x.AllLanes(y, [](double a, double b) { return a >= b; });
+  }
+  friend bool operator==(const Lanes& x, const Lanes& y) {
+    return x.AllLanes(y, [](double a, double b) { return a == b; });
+  }
+  friend bool operator!=(const Lanes& x, const Lanes& y) {
+    return !(x == y);
+  }
+
+  friend bool isfinite(const Lanes& x) {
+    return x.AllLanes(x, [](double a, double) { return std::isfinite(a); });
+  }
+  friend bool isinf(const Lanes& x) {
+    return x.AllLanes(x, [](double a, double) { return std::isinf(a); });
+  }
+  friend bool isnan(const Lanes& x) {
+    return x.AllLanes(x, [](double a, double) { return std::isnan(a); });
+  }
+  friend bool isnormal(const Lanes& x) {
+    return x.AllLanes(x, [](double a, double) { return std::isnormal(a); });
+  }
+  friend bool signbit(const Lanes& x) {
+    return x.AllLanes(x, [](double a, double) { return std::signbit(a); });
+  }
+  friend int fpclassify(const Lanes& x) {
+    const int category = std::fpclassify(x.values_[0]);
+    for (int i = 1; i < kNumLanes; ++i) {
+      if (std::fpclassify(x.values_[i]) != category) {
+        LanesDiverged() = true;
+      }
+    }
+    return category;
+  }
+
+  // Elementary functions. Those Eigen provides use its vectorized
+  // implementations where available, the others are applied lane by lane.
+  friend Lanes abs(const Lanes& x) {
+    return x.Map([](double a) { return std::abs(a); });
+  }
+  friend Lanes sqrt(const Lanes& x) { return Lanes(x.array().sqrt()); }
+  friend Lanes exp(const Lanes& x) { return Lanes(x.array().exp()); }
+  friend Lanes expm1(const Lanes& x) { return Lanes(x.array().expm1()); }
+  friend Lanes log(const Lanes& x) { return Lanes(x.array().log()); }
+  friend Lanes log1p(const Lanes& x) { return Lanes(x.array().log1p()); }
+  friend Lanes log10(const Lanes& x) { return Lanes(x.array().log10()); }
+  friend Lanes log2(const Lanes& x) { return Lanes(x.array().log2()); }
+  friend Lanes sin(const Lanes& x) { return Lanes(x.array().sin()); }
+  friend Lanes cos(const Lanes& x) { return Lanes(x.array().cos()); }
+  friend Lanes tan(const Lanes& x) { return Lanes(x.array().tan()); }
+  friend Lanes asin(const Lanes& x) { return Lanes(x.array().asin()); }
+  friend Lanes acos(const Lanes& x) { return Lanes(x.array().acos()); }
+  friend Lanes atan(const Lanes& x) { return Lanes(x.array().atan()); }
+  friend Lanes sinh(const Lanes& x) { return Lanes(x.array().sinh()); }
+  friend Lanes cosh(const Lanes& x) { return Lanes(x.array().cosh()); }
+  friend Lanes tanh(const Lanes& x) { return Lanes(x.array().tanh()); }
+  friend Lanes floor(const Lanes& x) { return Lanes(x.array().floor()); }
+  friend Lanes ceil(const Lanes& x) { return Lanes(x.array().ceil()); }
+  friend Lanes cbrt(const Lanes& x) {
+    return x.Map([](double a) { return std::cbrt(a); });
+  }
+  friend Lanes exp2(const Lanes& x) {
+    return x.Map([](double a) { return std::exp2(a); });
+  }
+  friend Lanes erf(const Lanes& x) {
+    return x.Map([](double a) { return std::erf(a); });
+  }
+  friend Lanes erfc(const Lanes& x) {
+    return x.Map([](double a) { return std::erfc(a); });
+  }
+
+  friend Lanes atan2(const Lanes& y, const Lanes& x) {
+    return y.Map(x, [](double a, double b) { return std::atan2(a, b); });
+  }
+  friend Lanes pow(const Lanes& x, const Lanes& y) {
+    return x.Map(y, [](double a, double b) { return std::pow(a, b); });
+  }
+  friend Lanes hypot(const Lanes& x, const Lanes& y) {
+    return x.Map(y, [](double a, double b) { return std::hypot(a, b); });
+  }
+  friend Lanes hypot(const Lanes& x, const Lanes& y, const Lanes& z) {
+    Lanes result;
+    for (int i = 0; i < kNumLanes; ++i) {
+      result[i] = std::hypot(x[i], y[i], z[i]);
+    }
+    return result;
+  }
+  friend Lanes copysign(const Lanes& x, const Lanes& y) {
+    return x.Map(y, [](double a, double b) { return std::copysign(a, b); });
+  }
+  friend Lanes fmax(const Lanes& x, const Lanes& y) {
+    return x.Map(y, [](double a, double b) { return std::fmax(a, b); });
+  }
+  friend Lanes fmin(const Lanes& x, const Lanes& y) {
+    return x.Map(y, [](double a, double b) { return std::fmin(a, b); });
+  }
+  friend Lanes fdim(const Lanes& x, const Lanes& y) {
+    return x.Map(y, [](double a, double b) { return std::fdim(a, b); });
+  }
+  friend Lanes fma(const Lanes& x, const Lanes& y, const Lanes& z) {
+    return x * y + z;
+  }
+
+  friend std::ostream& operator<<(std::ostream& s, const Lanes& x) {
+    return s << x.array().transpose();
+  }
+
+ private:
+  Eigen::Map<const Array> array() const {
+    return Eigen::Map<const Array>(values_);
+  }
+
+  template <typename Function>
+  Lanes& Apply(const Lanes& y, Function f) {
+    for (int i = 0; i < kNumLanes; ++i) {
+      f(values_[i], y.values_[i]);
+    }
+    return *this;
+  }
+  template <typename Function>
+  Lanes Map(Function f) const {
+    Lanes result;
+    for (int i = 0; i < kNumLanes; ++i) {
+      result.values_[i] = f(values_[i]);
+    }
+    return result;
+  }
+  template <typename Function>
+  Lanes Map(const Lanes& y, Function f) const {
+    Lanes result;
+    for (int i = 0; i < kNumLanes; ++i) {
+      result.values_[i] = f(values_[i], y.values_[i]);
+    }
+    return result;
+  }
+
+  // Reduces a per lane predicate to a single boolean, which is only
+  // meaningful if all the lanes agree.
+  template <typename Predicate>
+  bool AllLanes(const Lanes& y, Predicate p) const {
+    int count = 0;
+    for (int i = 0; i < kNumLanes; ++i) {
+      count += p(values_[i], y.values_[i]) ? 1 : 0;
+    }
+    if (count != 0 && count != kNumLanes) {
+      LanesDiverged() = true;
+    }
+    return count == kNumLanes;
+  }
+
+  double values_[kNumLanes];
+};
+
+}  // namespace internal
+}  // namespace ceres
+
+// The limits of Lanes are those of double, in all the lanes.
+template <int kNumLanes>
+class std::numeric_limits<ceres::internal::Lanes<kNumLanes>>
+    : public std::numeric_limits<double> {
+ public:
+  using Lanes = ceres::internal::Lanes<kNumLanes>;
+  static constexpr bool is_specialized = true;
+
+  static Lanes min() noexcept { return Lanes(numeric_limits<double>::min()); }
+  static Lanes max() noexcept { return Lanes(numeric_limits<double>::max()); }
+  static Lanes lowest() noexcept {
+    return Lanes(numeric_limits<double>::lowest());
+  }
+  static Lanes epsilon() noexcept {
+    return Lanes(numeric_limits<double>::epsilon());
+  }
+  static Lanes round_error() noexcept {
+    return Lanes(numeric_limits<double>::round_error());
+  }
+  static Lanes infinity() noexcept {
+    return Lanes(numeric_limits<double>::infinity());
+  }
+  static Lanes quiet_NaN() noexcept {
+    return Lanes(numeric_limits<double>::quiet_NaN());
+  }
+  static Lanes signaling_NaN() noexcept {
+    return Lanes(numeric_limits<double>::signaling_NaN());
+  }
+  static Lanes denorm_min() noexcept {
+    return Lanes(numeric_limits<double>::denorm_min());
+  }
+};
+
+namespace Eigen {
+
+// Lets Lanes be the scalar of the derivative part of a Jet, which is an
+// Eigen::Matrix.
+template <int kNumLanes>
+struct NumTraits<ceres::internal::Lanes<kNumLanes>> : NumTraits<double> {
+  using Real = ceres::internal::Lanes<kNumLanes>;
+  using NonInteger = Real;
+  using Nested = Real;
+  using Literal = Real;
+
+  static inline Real epsilon() { return Real(NumTraits<double>::epsilon()); }
+  static inline Real dummy_precision() {
+    return Real(NumTraits<double>::dummy_precision());
+  }
+  static inline Real highest() { return Real(NumTraits<double>::highest()); }
+  static inline Real lowest() { return Real(NumTraits<double>::lowest()); }
+
+  enum {
+    IsComplex = 0,
+    IsInteger = 0,
+    IsSigned = 1,
+    RequireInitialization = 1,
+    ReadCost = kNumLanes,
+    AddCost = kNumLanes,
+    MulCost = kNumLanes
+  };
+};
+
+}  // namespace Eigen
+
+#endif  // CERES_PUBLIC_INTERNAL_LANES_H_
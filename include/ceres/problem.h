@@ -39,6 +39,7 @@
 #include <map>
 #include <memory>
 #include <set>
+#include <utility>
 #include <vector>
 
 #include "ceres/context.h"
@@ -68,6 +69,77 @@ class ResidualBlock;
 // blocks from a Problem after adding them.
 using ResidualBlockId = internal::ResidualBlock*;
 
+// A ResidualBlockBatch stages residual and parameter blocks for insertion into
+// a Problem with Problem::AddResidualBlocks. Staging does not touch the
+// Problem, so different threads can fill different batches concurrently,
+// which are then merged into the Problem in a single pass, e.g.,
+//
+//   std::vector<ResidualBlockBatch> batches(num_threads);
+//   // On thread i:
+//   batches[i].AddResidualBlock(new MyCostFunction(...), nullptr, x1, x2);
+//   ...
+//   // Once all threads are done:
+//   problem.AddResidualBlocks(batches, num_threads, nullptr);
+//
+// A batch does not take ownership of the cost and loss functions added to it,
+// they are owned by the Problem (as specified by Problem::Options) only once
+// the batch has been added to it. The arguments are validated when the batch is
+// added to the Problem, with the same checks as Problem::AddResidualBlock and
+// Problem::AddParameterBlock.
+class CERES_EXPORT ResidualBlockBatch {
+ public:
+  // Stage a residual block. See Problem::AddResidualBlock for the meaning of
+  // the arguments.
+  template <typename... Ts>
+  void AddResidualBlock(CostFunction* cost_function,
+                        LossFunction* loss_function,
+                        double* x0,
+                        Ts*... xs) {
+    const std::array<double*, sizeof...(Ts) + 1> parameter_blocks{{x0, xs...}};
+    AddResidualBlock(cost_function,
+                     loss_function,
+                     parameter_blocks.data(),
+                     static_cast<int>(parameter_blocks.size()));
+  }
+  void AddResidualBlock(CostFunction* cost_function,
+                        LossFunction* loss_function,
+                        const std::vector<double*>& parameter_blocks);
+  void AddResidualBlock(CostFunction* cost_function,
+                        LossFunction* loss_function,
+                        double* const* const parameter_blocks,
+                        int num_parameter_blocks);
+
+  // Stage a parameter block. The parameter blocks staged in a batch are added
+  // to the Problem before its residual blocks.
+  void AddParameterBlock(double* values, int size);
+
+  int NumResidualBlocks() const {
+    return static_cast<int>(residual_blocks_.size());
+  }
+  int NumParameterBlocks() const {
+    return static_cast<int>(parameter_blocks_.size());
+  }
+
+  // Remove all the staged residual and parameter blocks.
+  void Clear();
+
+ private:
+  friend class internal::ProblemImpl;
+
+  struct StagedResidualBlock {
+    CostFunction* cost_function;
+    LossFunction* loss_function;
+    // The parameter blocks of the residual block are
+    // residual_parameter_blocks_[begin, begin + size).
+    int begin;
+    int size;
+  };
+
+  std::vector<StagedResidualBlock> residual_blocks_;
+  std::vector<double*> residual_parameter_blocks_;
+  std::vector<std::pair<double*, int>> parameter_blocks_;
+};
+
 // A class to represent non-linear least squares problems. Such
 // problems have a cost function that is a sum of error terms (known
 // as "residuals"), where each residual is a function of some subset
@@ -253,6 +325,18 @@ class CERES_EXPORT Problem {
                                    double* const* const parameter_blocks,
                                    int num_parameter_blocks);
 
+  // Add the parameter and residual blocks staged in batches to the problem,
+  // using num_threads threads to validate them and to create the residual
+  // blocks. The result is the same as calling AddParameterBlock and
+  // AddResidualBlock for each of the staged blocks, in the order of the
+  // batches. If residual_block_ids is not nullptr, it is set to the ids of
+  // the new residual blocks, in the same order.
+  //
+  // The threads are taken from Problem::Options::context.
+  void AddResidualBlocks(const std::vector<ResidualBlockBatch>& batches,
+                         int num_threads,
+                         std::vector<ResidualBlockId>* residual_block_ids);
+
   // Add a parameter block with appropriate size to the problem. Repeated calls
   // with the same arguments are ignored. Repeated calls with the same double
   // pointer but a different size will result in a crash.
@@ -44,6 +44,7 @@
 #include "ceres/iteration_callback.h"
 #include "ceres/ordered_groups.h"
 #include "ceres/problem.h"
+#include "ceres/solver_plan.h"
 #include "ceres/types.h"
 
 namespace ceres {
@@ -539,6 +540,28 @@ class CERES_EXPORT Solver {
     // preconditioner.
     bool use_explicit_schur_complement = false;
 
+    // When eliminating the e blocks to form the reduced camera system
+    // (DENSE_SCHUR, SPARSE_SCHUR, ITERATIVE_SCHUR with an explicit
+    // Schur complement, and the SCHUR_JACOBI, CLUSTER_JACOBI and
+    // CLUSTER_TRIDIAGONAL preconditioners), the threads update the
+    // shared blocks of the reduced linear system under per block
+    // locks. If many e blocks share the same f blocks (e.g., bundle
+    // adjustment problems with a large overlap between the views of
+    // the cameras), contention on these locks limits scaling with the
+    // number of threads.
+    //
+    // Enabling this option splits the elimination into two lock free
+    // passes. The first pass computes the per e block products in
+    // parallel over the e blocks. The second pass assembles the reduced
+    // linear system in parallel over its block rows, with every block
+    // row updated by exactly one thread.
+    //
+    // The intermediate products are stored between the two passes,
+    // which requires memory comparable to the size of the Jacobian.
+    //
+    // This option has no effect if num_threads = 1.
+    bool use_lock_free_schur_elimination = false;
+
     // Sparse Cholesky factorization algorithms use a fill-reducing
     // ordering to permute the columns of the Jacobian matrix. There
     // are two ways of doing this.
@@ -812,6 +835,15 @@ class CERES_EXPORT Solver {
     //
     // The solver does NOT take ownership of these pointers.
     std::vector<IterationCallback*> callbacks;
+
+    // If not nullptr, the symbolic analysis of the problem (reduced
+    // program, fill reducing ordering, Jacobian structure, symbolic
+    // factorization etc.) is stored in and reused from this
+    // SolverPlan across calls to Solve on a structurally identical
+    // problem. See solver_plan.h for details.
+    //
+    // The solver does NOT take ownership of the pointer.
+    SolverPlan* solver_plan = nullptr;
   };
 
   struct CERES_EXPORT Summary {
@@ -0,0 +1,91 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef CERES_PUBLIC_SOLVER_PLAN_H_
+#define CERES_PUBLIC_SOLVER_PLAN_H_
+
+#include <memory>
+
+#include "ceres/internal/disable_warnings.h"
+#include "ceres/internal/export.h"
+
+namespace ceres {
+
+namespace internal {
+class SolverPlanImpl;
+}  // namespace internal
+
+// A SolverPlan stores the results of the symbolic analysis performed by
+// Solver::Solve, i.e., the reduced program and its fill reducing ordering,
+// the structure of the Jacobian, the linear solver along with its symbolic
+// factorization or Schur complement structure, and the evaluator.
+//
+// If Solver::Options::solver_plan points to a SolverPlan, then Solve
+// populates it on the first call. Subsequent calls on the same Problem reuse
+// the stored state instead of preprocessing the problem again, as long as
+//
+//   1. The structure of the problem did not change, i.e., no residual or
+//      parameter blocks were added or removed, no parameter block was made
+//      constant or variable and no manifold was changed.
+//   2. The options which affect the symbolic analysis, e.g., the linear
+//      solver type, the orderings or the number of threads, did not change.
+//
+// Otherwise, the problem is preprocessed again and the plan is updated.
+// Only the values of the parameter blocks (and their bounds) can change
+// between calls which reuse the plan; these are read from the user's
+// parameter blocks at the start of every Solve. Options which do not affect
+// the symbolic analysis, e.g., tolerances, iteration limits or callbacks, can
+// be changed freely.
+//
+// A SolverPlan is not thread safe and must not be used by concurrent calls
+// to Solve. It does not take ownership of the Problem, and it must not be
+// used with Solver::Options::check_gradients, in which case it is ignored.
+class CERES_EXPORT SolverPlan {
+ public:
+  SolverPlan();
+  SolverPlan(const SolverPlan&) = delete;
+  void operator=(const SolverPlan&) = delete;
+  ~SolverPlan();
+
+  // Discards the stored state, forcing the next call to Solve to preprocess
+  // the problem.
+  void Reset();
+
+  // Returns pointer to SolverPlan implementation.
+  internal::SolverPlanImpl* mutable_impl();
+
+ private:
+  std::unique_ptr<internal::SolverPlanImpl> impl_;
+};
+
+}  // namespace ceres
+
+#include "ceres/internal/reenable_warnings.h"
+
+#endif  // CERES_PUBLIC_SOLVER_PLAN_H_
@@ -0,0 +1,351 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/autodiff_batch_cost_function.h"
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "ceres/autodiff_cost_function.h"
+#include "ceres/crs_matrix.h"
+#include "ceres/problem.h"
+#include "ceres/rotation.h"
+#include "gtest/gtest.h"
+
+namespace ceres::internal {
+
+namespace {
+
+// A reprojection error in the style of the BAL problems, with the
+// observation as per residual block data. The camera is an angle-axis
+// rotation, a translation and a focal length.
+struct ReprojectionError {
+  static constexpr int kNumData = 2;
+
+  template <typename S, typename T>
+  bool operator()(const S* observation,
+                  const T* camera,
+                  const T* point,
+                  T* residuals) const {
+    T p[3];
+    AngleAxisRotatePoint(camera, point, p);
+    p[0] += camera[3];
+    p[1] += camera[4];
+    p[2] += camera[5];
+    residuals[0] = camera[6] * p[0] / p[2] - observation[0];
+    residuals[1] = camera[6] * p[1] / p[2] - observation[1];
+    return true;
+  }
+};
+
+// The same reprojection error, for AutoDiffCostFunction.
+struct ScalarReprojectionError {
+  ScalarReprojectionError(double x, double y) : observation{x, y} {}
+
+  template <typename T>
+  bool operator()(const T* camera, const T* point, T* residuals) const {
+    return ReprojectionError()(observation, camera, point, residuals);
+  }
+
+  double observation[2];
+};
+
+// A functor without per residual block data, with a branch.
+struct Branch {
+  template <typename T>
+  bool operator()(const T* x, T* residuals) const {
+    if (x[0] < T(0.0)) {
+      residuals[0] = -x[0] * x[1];
+    } else {
+      residuals[0] = sqrt(x[0]) + x[1];
+    }
+    return true;
+  }
+};
+
+// Fails for negative x.
+struct Positive {
+  template <typename T>
+  bool operator()(const T* x, T* residuals) const {
+    residuals[0] = x[0];
+    return x[0] >= T(0.0);
+  }
+};
+
+using BatchReprojectionError =
+    AutoDiffBatchCostFunction<ReprojectionError, 2, 7, 3>;
+
+// The residual blocks of a batch and their parameters, in the structure of
+// arrays layout of BatchCostFunction::EvaluateBatch.
+struct Batch {
+  // Evaluates the batch, with the jacobians of the parameter blocks for
+  // which jacobian_blocks is true.
+  bool Evaluate(std::vector<bool> jacobian_blocks, bool with_jacobians) {
+    const int n = cost_functions.size();
+    const auto& sizes = cost_functions[0]->parameter_block_sizes();
+    residuals.assign(cost_functions[0]->num_residuals() * n, 0.0);
+    jacobians.clear();
+    std::vector<double*> parameter_ptrs;
+    std::vector<double*> jacobian_ptrs;
+    for (int b = 0; b < sizes.size(); ++b) {
+      parameter_ptrs.push_back(parameters[b].data());
+      jacobians.emplace_back(sizes[b] * cost_functions[0]->num_residuals() * n,
+                             -1.0);
+      jacobian_ptrs.push_back(jacobian_blocks[b] ? jacobians[b].data()
+                                                 : nullptr);
+    }
+    std::vector<const BatchCostFunction*> batch;
+    for (const auto& cost_function : cost_functions) {
+      batch.push_back(cost_function.get());
+    }
+    return batch[0]->EvaluateBatch(n,
+                                   batch.data(),
+                                   parameter_ptrs.data(),
+                                   residuals.data(),
+                                   with_jacobians ? jacobian_ptrs.data()
+                                                  : nullptr);
+  }
+
+  // The parameters of residual block k.
+  std::vector<double> BlockParameters(int b, int k) const {
+    const int n = cost_functions.size();
+    const int size = cost_functions[0]->parameter_block_sizes()[b];
+    std::vector<double> values(size);
+    for (int j = 0; j < size; ++j) {
+      values[j] = parameters[b][j * n + k];
+    }
+    return values;
+  }
+
+  std::vector<std::unique_ptr<BatchCostFunction>> cost_functions;
+  std::vector<std::vector<double>> parameters;
+  std::vector<double> residuals;
+  std::vector<std::vector<double>> jacobians;
+};
+
+// Builds a batch of n reprojection errors. If zero_rotations is true, every
+// third camera has no rotation, which takes another branch of
+// AngleAxisRotatePoint than the others.
+Batch MakeReprojectionBatch(int n,
+                            bool zero_rotations,
+                            std::vector<ScalarReprojectionError>* scalar) {
+  std::mt19937 prng(n);
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  Batch batch;
+  batch.parameters.assign(2, {});
+  batch.parameters[0].resize(7 * n);
+  batch.parameters[1].resize(3 * n);
+  for (int k = 0; k < n; ++k) {
+    for (int j = 0; j < 3; ++j) {
+      batch.parameters[0][j * n + k] =
+          zero_rotations && k % 3 == 0 ? 0.0 : 0.3 * uniform(prng);
+      batch.parameters[0][(3 + j) * n + k] = uniform(prng);
+      batch.parameters[1][j * n + k] = uniform(prng);
+    }
+    batch.parameters[0][5 * n + k] += 10.0;
+    batch.parameters[0][6 * n + k] = 500.0 + uniform(prng);
+    const double x = uniform(prng);
+    const double y = uniform(prng);
+    batch.cost_functions.push_back(
+        std::make_unique<BatchReprojectionError>(x, y));
+    scalar->emplace_back(x, y);
+  }
+  return batch;
+}
+
+// Expects the evaluation of the batch to match that of AutoDiffCostFunction,
+// residual block by residual block.
+void ExpectMatchesAutoDiff(const Batch& batch,
+                           const std::vector<ScalarReprojectionError>& scalar,
+                           const std::vector<bool>& jacobian_blocks,
+                           bool with_jacobians) {
+  const int n = batch.cost_functions.size();
+  for (int k = 0; k < n; ++k) {
+    AutoDiffCostFunction<ScalarReprojectionError, 2, 7, 3> cost_function(
+        scalar[k]);
+    const std::vector<double> camera = batch.BlockParameters(0, k);
+    const std::vector<double> point = batch.BlockParameters(1, k);
+    const double* parameters[] = {camera.data(), point.data()};
+    double residuals[2];
+    double jacobian_camera[2 * 7];
+    double jacobian_point[2 * 3];
+    double* jacobians[] = {jacobian_camera, jacobian_point};
+    ASSERT_TRUE(cost_function.Evaluate(parameters, residuals, jacobians));
+
+    for (int i = 0; i < 2; ++i) {
+      EXPECT_NEAR(batch.residuals[i * n + k],
+                  residuals[i],
+                  1e-12 * std::abs(residuals[i]));
+    }
+    const int sizes[] = {7, 3};
+    for (int b = 0; b < 2; ++b) {
+      for (int i = 0; i < 2 * sizes[b]; ++i) {
+        const double value = batch.jacobians[b][i * n + k];
+        if (!with_jacobians || !jacobian_blocks[b]) {
+          EXPECT_EQ(value, -1.0);
+        } else {
+          EXPECT_NEAR(value, jacobians[b][i], 1e-12 * std::abs(jacobians[b][i]))
+              << "block " << b << " entry " << i << " residual block " << k;
+        }
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(AutoDiffBatchCostFunction, MatchesAutoDiffCostFunction) {
+  for (int n = 1; n <= 9; ++n) {
+    std::vector<ScalarReprojectionError> scalar;
+    Batch batch = MakeReprojectionBatch(n, false, &scalar);
+    for (bool with_jacobians : {false, true}) {
+      for (const std::vector<bool>& jacobian_blocks :
+           {std::vector<bool>{true, true}, std::vector<bool>{false, true}}) {
+        ASSERT_TRUE(batch.Evaluate(jacobian_blocks, with_jacobians));
+        // All the rotations take the same branch, so the lanes are evaluated
+        // together.
+        EXPECT_FALSE(LanesDiverged());
+        ExpectMatchesAutoDiff(batch, scalar, jacobian_blocks, with_jacobians);
+      }
+    }
+  }
+}
+
+TEST(AutoDiffBatchCostFunction, DivergentLanesAreEvaluatedOneByOne) {
+  std::vector<ScalarReprojectionError> scalar;
+  Batch batch = MakeReprojectionBatch(9, true, &scalar);
+  for (bool with_jacobians : {false, true}) {
+    ASSERT_TRUE(batch.Evaluate({true, true}, with_jacobians));
+    ExpectMatchesAutoDiff(batch, scalar, {true, true}, with_jacobians);
+  }
+
+  // Alternating branches in a functor without per residual block data.
+  Batch branches;
+  const int n = 5;
+  branches.parameters = {{-1.0, 2.0, -3.0, 4.0, 5.0, 1.0, 2.0, 3.0, 4.0, 5.0}};
+  for (int k = 0; k < n; ++k) {
+    branches.cost_functions.push_back(
+        std::make_unique<AutoDiffBatchCostFunction<Branch, 1, 2>>());
+  }
+  ASSERT_TRUE(branches.Evaluate({true}, true));
+  for (int k = 0; k < n; ++k) {
+    const double x0 = branches.parameters[0][k];
+    const double x1 = branches.parameters[0][n + k];
+    if (x0 < 0.0) {
+      EXPECT_EQ(branches.residuals[k], -x0 * x1);
+      EXPECT_EQ(branches.jacobians[0][k], -x1);
+      EXPECT_EQ(branches.jacobians[0][n + k], -x0);
+    } else {
+      EXPECT_EQ(branches.residuals[k], std::sqrt(x0) + x1);
+      EXPECT_EQ(branches.jacobians[0][k], 0.5 / std::sqrt(x0));
+      EXPECT_EQ(branches.jacobians[0][n + k], 1.0);
+    }
+  }
+}
+
+TEST(AutoDiffBatchCostFunction, FailsIfAnyResidualBlockFails) {
+  Batch batch;
+  batch.parameters = {{1.0, 2.0, 3.0, 4.0, 5.0}};
+  for (int k = 0; k < 5; ++k) {
+    batch.cost_functions.push_back(
+        std::make_unique<AutoDiffBatchCostFunction<Positive, 1, 1>>());
+  }
+  EXPECT_TRUE(batch.Evaluate({true}, true));
+  batch.parameters[0][4] = -1.0;
+  EXPECT_FALSE(batch.Evaluate({true}, true));
+  EXPECT_FALSE(batch.Evaluate({true}, false));
+}
+
+TEST(AutoDiffBatchCostFunction, MatchesAutoDiffCostFunctionInProblem) {
+  constexpr int kNumCameras = 3;
+  constexpr int kNumPoints = 20;
+  std::mt19937 prng;
+  std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+  double cameras[kNumCameras][7];
+  double points[kNumPoints][3];
+  for (auto& camera : cameras) {
+    for (int j = 0; j < 6; ++j) {
+      camera[j] = 0.3 * uniform(prng);
+    }
+    camera[5] += 10.0;
+    camera[6] = 500.0;
+  }
+  for (auto& point : points) {
+    for (double& x : point) {
+      x = uniform(prng);
+    }
+  }
+
+  Problem batched_problem;
+  Problem problem;
+  for (auto& point : points) {
+    for (auto& camera : cameras) {
+      const double x = uniform(prng);
+      const double y = uniform(prng);
+      batched_problem.AddResidualBlock(
+          new BatchReprojectionError(x, y), nullptr, camera, point);
+      problem.AddResidualBlock(
+          new AutoDiffCostFunction<ScalarReprojectionError, 2, 7, 3>(x, y),
+          nullptr,
+          camera,
+          point);
+    }
+  }
+
+  double expected_cost;
+  std::vector<double> expected_residuals;
+  CRSMatrix expected_jacobian;
+  ASSERT_TRUE(problem.Evaluate(Problem::EvaluateOptions(),
+                               &expected_cost,
+                               &expected_residuals,
+                               nullptr,
+                               &expected_jacobian));
+  double cost;
+  std::vector<double> residuals;
+  CRSMatrix jacobian;
+  ASSERT_TRUE(batched_problem.Evaluate(
+      Problem::EvaluateOptions(), &cost, &residuals, nullptr, &jacobian));
+
+  EXPECT_NEAR(cost, expected_cost, 1e-12 * expected_cost);
+  ASSERT_EQ(residuals.size(), expected_residuals.size());
+  for (int i = 0; i < residuals.size(); ++i) {
+    EXPECT_NEAR(residuals[i], expected_residuals[i], 1e-9);
+  }
+  EXPECT_EQ(jacobian.cols, expected_jacobian.cols);
+  EXPECT_EQ(jacobian.rows, expected_jacobian.rows);
+  ASSERT_EQ(jacobian.values.size(), expected_jacobian.values.size());
+  for (int i = 0; i < jacobian.values.size(); ++i) {
+    EXPECT_NEAR(jacobian.values[i],
+                expected_jacobian.values[i],
+                1e-9 * std::abs(expected_jacobian.values[i]));
+  }
+}
+
+}  // namespace ceres::internal
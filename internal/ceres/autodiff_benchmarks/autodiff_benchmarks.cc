@@ -31,8 +31,10 @@
 #include <memory>
 #include <random>
 #include <utility>
+#include <vector>
 
 #include "benchmark/benchmark.h"
+#include "ceres/autodiff_batch_cost_function.h"
 #include "ceres/autodiff_benchmarks/brdf_cost_function.h"
 #include "ceres/autodiff_benchmarks/constant_cost_function.h"
 #include "ceres/autodiff_benchmarks/linear_cost_functions.h"
@@ -425,6 +427,121 @@ static void BM_BrdfAutoDiff(benchmark::State& state) {
 BENCHMARK_TEMPLATE(BM_BrdfAutoDiff, kNotDynamic)->Arg(0)->Arg(1);
 BENCHMARK_TEMPLATE(BM_BrdfAutoDiff, kDynamic)->Arg(0)->Arg(1);
 
+// The number of residual blocks evaluated by each iteration of the
+// benchmarks of AutoDiffBatchCostFunction, which is the default maximum batch
+// size of BatchCostFunction.
+constexpr int kBatchSize = 16;
+
+// Evaluates the batch of residual blocks with the given cost functions, all
+// of which have the given parameters. The per_residual_block counter is the
+// time per residual block, to compare with the benchmarks of a single
+// residual block above.
+static void EvaluateBatch(
+    benchmark::State& state,
+    const std::vector<std::unique_ptr<BatchCostFunction>>& cost_functions,
+    const std::vector<const double*>& parameters) {
+  CHECK_EQ(cost_functions.size(), kBatchSize);
+  const BatchCostFunction& cost_function = *cost_functions[0];
+  const int num_residuals = cost_function.num_residuals();
+  const std::vector<int32_t>& block_sizes =
+      cost_function.parameter_block_sizes();
+
+  std::vector<std::vector<double>> batch_parameters;
+  std::vector<std::vector<double>> batch_jacobians;
+  std::vector<const double*> parameter_ptrs;
+  std::vector<double*> jacobian_ptrs;
+  for (int i = 0; i < block_sizes.size(); ++i) {
+    batch_parameters.emplace_back(block_sizes[i] * kBatchSize);
+    for (int j = 0; j < block_sizes[i]; ++j) {
+      for (int k = 0; k < kBatchSize; ++k) {
+        batch_parameters[i][j * kBatchSize + k] = parameters[i][j];
+      }
+    }
+    batch_jacobians.emplace_back(num_residuals * block_sizes[i] * kBatchSize);
+  }
+  for (int i = 0; i < block_sizes.size(); ++i) {
+    parameter_ptrs.push_back(batch_parameters[i].data());
+    jacobian_ptrs.push_back(batch_jacobians[i].data());
+  }
+  std::vector<double> residuals(num_residuals * kBatchSize);
+  std::vector<const BatchCostFunction*> batch;
+  for (const auto& batch_cost_function : cost_functions) {
+    batch.push_back(batch_cost_function.get());
+  }
+
+  double** jacobians = state.range(0) ? jacobian_ptrs.data() : nullptr;
+  for (auto _ : state) {
+    cost_function.EvaluateBatch(kBatchSize,
+                                batch.data(),
+                                parameter_ptrs.data(),
+                                residuals.data(),
+                                jacobians);
+  }
+  state.counters["per_residual_block"] = benchmark::Counter(
+      kBatchSize,
+      benchmark::Counter::kIsIterationInvariantRate |
+          benchmark::Counter::kInvert);
+}
+
+static void BM_SnavelyReprojectionBatchAutoDiff(benchmark::State& state) {
+  double parameter_block1[] = {1., 2., 3., 4., 5., 6., 7., 8., 9.};
+  double parameter_block2[] = {1., 2., 3.};
+
+  std::vector<std::unique_ptr<BatchCostFunction>> cost_functions;
+  for (int k = 0; k < kBatchSize; ++k) {
+    cost_functions.push_back(
+        std::make_unique<
+            AutoDiffBatchCostFunction<BatchSnavelyReprojectionError, 2, 9, 3>>(
+            0.2 + 0.01 * k, 0.3));
+  }
+  EvaluateBatch(state, cost_functions, {parameter_block1, parameter_block2});
+}
+
+BENCHMARK(BM_SnavelyReprojectionBatchAutoDiff)->Arg(0)->Arg(1);
+
+static void BM_RelativePoseBatchAutoDiff(benchmark::State& state) {
+  double parameter_block1[] = {1., 2., 3., 4., 5., 6., 7.};
+  double parameter_block2[] = {1.1, 2.1, 3.1, 4.1, 5.1, 6.1, 7.1};
+
+  Eigen::Map<Eigen::Quaterniond>(parameter_block1).normalize();
+  Eigen::Map<Eigen::Quaterniond>(parameter_block2).normalize();
+
+  using CostFunctionType =
+      AutoDiffBatchCostFunction<BatchRelativePoseError, 6, 7, 7>;
+  const Eigen::Quaterniond q_i_j = Eigen::Quaterniond(1, 2, 3, 4).normalized();
+  std::vector<std::unique_ptr<BatchCostFunction>> cost_functions;
+  for (int k = 0; k < kBatchSize; ++k) {
+    cost_functions.push_back(std::make_unique<CostFunctionType>(
+        q_i_j.x(), q_i_j.y(), q_i_j.z(), q_i_j.w(), 1.0 + k, 2.0, 3.0));
+  }
+  EvaluateBatch(state, cost_functions, {parameter_block1, parameter_block2});
+}
+
+BENCHMARK(BM_RelativePoseBatchAutoDiff)->Arg(0)->Arg(1);
+
+static void BM_BrdfBatchAutoDiff(benchmark::State& state) {
+  double material[] = {1., 2., 3., 4., 5., 6., 7., 8., 9., 10.};
+  auto c = Eigen::Vector3d(0.1, 0.2, 0.3);
+  auto n = Eigen::Vector3d(-0.1, 0.5, 0.2).normalized();
+  auto v = Eigen::Vector3d(0.5, -0.2, 0.9).normalized();
+  auto l = Eigen::Vector3d(-0.3, 0.4, -0.3).normalized();
+  auto x = Eigen::Vector3d(0.5, 0.7, -0.1).normalized();
+  auto y = Eigen::Vector3d(0.2, -0.2, -0.2).normalized();
+
+  std::vector<std::unique_ptr<BatchCostFunction>> cost_functions;
+  for (int k = 0; k < kBatchSize; ++k) {
+    cost_functions.push_back(
+        std::make_unique<
+            AutoDiffBatchCostFunction<Brdf, 3, 10, 3, 3, 3, 3, 3, 3>>());
+  }
+  EvaluateBatch(
+      state,
+      cost_functions,
+      {material, c.data(), n.data(), v.data(), l.data(), x.data(), y.data()});
+}
+
+BENCHMARK(BM_BrdfBatchAutoDiff)->Arg(0)->Arg(1);
+
 }  // namespace ceres
 
 BENCHMARK_MAIN();
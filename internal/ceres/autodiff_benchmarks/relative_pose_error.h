@@ -33,7 +33,7 @@
 #define CERES_INTERNAL_AUTODIFF_BENCHMARK_RELATIVE_POSE_ERROR_H_
 
 #include <Eigen/Dense>
-#include <utility>
+#include <algorithm>
 
 #include "ceres/rotation.h"
 
@@ -44,13 +44,28 @@ namespace ceres {
 // poses T_w_i and T_w_j. For the residual we use the log of the the residual
 // pose, in split representation SO(3) x R^3.
 struct RelativePoseError {
-  RelativePoseError(Eigen::Quaterniond q_i_j, Eigen::Vector3d t_i_j)
-      : meas_q_i_j_(std::move(q_i_j)), meas_t_i_j_(std::move(t_i_j)) {}
+  RelativePoseError(Eigen::Quaterniond q_i_j, Eigen::Vector3d t_i_j) {
+    std::copy_n(q_i_j.coeffs().data(), 4, measurement_);
+    std::copy_n(t_i_j.data(), 3, measurement_ + 4);
+  }
 
   template <typename T>
   inline bool operator()(const T* const pose_i_ptr,
                          const T* const pose_j_ptr,
                          T* residuals_ptr) const {
+    return Residuals(measurement_, pose_i_ptr, pose_j_ptr, residuals_ptr);
+  }
+
+  // The measurement is the quaternion, in Eigen's xyzw order, followed by the
+  // translation. S is its scalar type, which holds the measurements of
+  // several residual blocks when evaluated by AutoDiffBatchCostFunction.
+  template <typename S, typename T>
+  static inline bool Residuals(const S* const measurement,
+                               const T* const pose_i_ptr,
+                               const T* const pose_j_ptr,
+                               T* residuals_ptr) {
+    Eigen::Map<const Eigen::Quaternion<S>> meas_q_i_j(measurement);
+    Eigen::Map<const Eigen::Matrix<S, 3, 1>> meas_t_i_j(measurement + 4);
     Eigen::Map<const Eigen::Quaternion<T>> q_w_i(pose_i_ptr);
     Eigen::Map<const Eigen::Matrix<T, 3, 1>> t_w_i(pose_i_ptr + 4);
     Eigen::Map<const Eigen::Quaternion<T>> q_w_j(pose_j_ptr);
@@ -63,9 +78,10 @@ struct RelativePoseError {
         q_w_j.conjugate() * (t_w_i - t_w_j);
 
     // Compute residual pose.
-    const Eigen::Quaternion<T> res_q = meas_q_i_j_.cast<T>() * est_q_j_i;
+    const Eigen::Quaternion<T> res_q =
+        meas_q_i_j.template cast<T>() * est_q_j_i;
     const Eigen::Matrix<T, 3, 1> res_t =
-        meas_q_i_j_.cast<T>() * est_t_j_i + meas_t_i_j_;
+        meas_q_i_j.template cast<T>() * est_t_j_i + meas_t_i_j;
 
     // Convert quaternion to ceres convention (Eigen stores xyzw, Ceres wxyz).
     Eigen::Matrix<T, 4, 1> res_q_ceres;
@@ -80,8 +96,22 @@ struct RelativePoseError {
 
  private:
   // Measurement of relative pose from j to i.
-  Eigen::Quaterniond meas_q_i_j_;
-  Eigen::Vector3d meas_t_i_j_;
+  double measurement_[7];
+};
+
+// RelativePoseError for AutoDiffBatchCostFunction, with the measurement as
+// per residual block data.
+struct BatchRelativePoseError {
+  static constexpr int kNumData = 7;
+
+  template <typename S, typename T>
+  inline bool operator()(const S* const measurement,
+                         const T* const pose_i_ptr,
+                         const T* const pose_j_ptr,
+                         T* residuals_ptr) const {
+    return RelativePoseError::Residuals(
+        measurement, pose_i_ptr, pose_j_ptr, residuals_ptr);
+  }
 };
 }  // namespace ceres
 #endif  // CERES_INTERNAL_AUTODIFF_BENCHMARK_RELATIVE_POSE_ERROR_H_
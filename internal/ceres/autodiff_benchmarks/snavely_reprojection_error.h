@@ -44,8 +44,19 @@ struct SnavelyReprojectionError {
   inline bool operator()(const T* const camera,
                          const T* const point,
                          T* residuals) const {
-    T ox = T(observed_x);
-    T oy = T(observed_y);
+    const double observation[] = {observed_x, observed_y};
+    return Residuals(observation, camera, point, residuals);
+  }
+
+  // S is the scalar type of the observation, which holds the observations of
+  // several residual blocks when evaluated by AutoDiffBatchCostFunction.
+  template <typename S, typename T>
+  static inline bool Residuals(const S* const observation,
+                               const T* const camera,
+                               const T* const point,
+                               T* residuals) {
+    T ox = T(observation[0]);
+    T oy = T(observation[1]);
 
     // camera[0,1,2] are the angle-axis rotation.
     T p[3];
@@ -82,5 +93,20 @@ struct SnavelyReprojectionError {
   double observed_x;
   double observed_y;
 };
+
+// SnavelyReprojectionError for AutoDiffBatchCostFunction, with the
+// observation as per residual block data.
+struct BatchSnavelyReprojectionError {
+  static constexpr int kNumData = 2;
+
+  template <typename S, typename T>
+  inline bool operator()(const S* const observation,
+                         const T* const camera,
+                         const T* const point,
+                         T* residuals) const {
+    return SnavelyReprojectionError::Residuals(
+        observation, camera, point, residuals);
+  }
+};
 }  // namespace ceres
 #endif  // CERES_INTERNAL_AUTODIFF_BENCHMARK_SNAVELY_REPROJECTION_ERROR_H_
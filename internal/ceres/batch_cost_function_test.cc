@@ -0,0 +1,276 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/batch_cost_function.h"
+
+#include <memory>
+#include <vector>
+
+#include "ceres/crs_matrix.h"
+#include "ceres/loss_function.h"
+#include "ceres/manifold.h"
+#include "ceres/problem.h"
+#include "ceres/parameter_block.h"
+#include "ceres/problem_impl.h"
+#include "ceres/program.h"
+#include "ceres/residual_block.h"
+#include "ceres/residual_block_batch.h"
+#include "gtest/gtest.h"
+
+namespace ceres::internal {
+
+// r = [a * x0 + y0 - b, x1 * y1], where a and b are per residual block data.
+class LinearBatchCostFunction : public BatchCostFunction {
+ public:
+  LinearBatchCostFunction(double a, double b, int max_batch_size)
+      : a_(a), b_(b) {
+    set_num_residuals(2);
+    *mutable_parameter_block_sizes() = {2, 2};
+    set_max_batch_size(max_batch_size);
+  }
+
+  bool EvaluateBatch(int batch_size,
+                     const BatchCostFunction* const* cost_functions,
+                     double const* const* parameters,
+                     double* residuals,
+                     double** jacobians) const final {
+    const int n = batch_size;
+    for (int k = 0; k < n; ++k) {
+      const auto* f =
+          static_cast<const LinearBatchCostFunction*>(cost_functions[k]);
+      const double x0 = parameters[0][k];
+      const double x1 = parameters[0][n + k];
+      const double y0 = parameters[1][k];
+      const double y1 = parameters[1][n + k];
+      residuals[k] = f->a_ * x0 + y0 - f->b_;
+      residuals[n + k] = x1 * y1;
+      if (jacobians == nullptr) {
+        continue;
+      }
+      if (jacobians[0] != nullptr) {
+        jacobians[0][0 * n + k] = f->a_;
+        jacobians[0][1 * n + k] = 0.0;
+        jacobians[0][2 * n + k] = 0.0;
+        jacobians[0][3 * n + k] = y1;
+      }
+      if (jacobians[1] != nullptr) {
+        jacobians[1][0 * n + k] = 1.0;
+        jacobians[1][1 * n + k] = 0.0;
+        jacobians[1][2 * n + k] = 0.0;
+        jacobians[1][3 * n + k] = x1;
+      }
+    }
+    return true;
+  }
+
+ private:
+  double a_;
+  double b_;
+};
+
+// Evaluates a batch cost function on its own, hiding that it is one, so that
+// the evaluator does not batch it.
+class UnbatchedCostFunction : public CostFunction {
+ public:
+  explicit UnbatchedCostFunction(std::unique_ptr<CostFunction> cost_function)
+      : cost_function_(std::move(cost_function)) {
+    set_num_residuals(cost_function_->num_residuals());
+    *mutable_parameter_block_sizes() = cost_function_->parameter_block_sizes();
+  }
+
+  bool Evaluate(double const* const* parameters,
+                double* residuals,
+                double** jacobians) const final {
+    return cost_function_->Evaluate(parameters, residuals, jacobians);
+  }
+
+ private:
+  std::unique_ptr<CostFunction> cost_function_;
+};
+
+class BatchCostFunctionTest : public ::testing::Test {
+ protected:
+  static constexpr int kNumPoints = 10;
+  static constexpr int kNumCameras = 3;
+
+  void SetUp() final {
+    for (int i = 0; i < kNumPoints; ++i) {
+      points_[i][0] = 0.5 + i;
+      points_[i][1] = -1.0 + 0.25 * i;
+    }
+    for (int j = 0; j < kNumCameras; ++j) {
+      cameras_[j][0] = 2.0 - j;
+      cameras_[j][1] = 0.5 * j + 1.0;
+    }
+  }
+
+  // Builds the same problem with batched and with unbatched cost functions.
+  // It has a loss function, a constant parameter block and a manifold, so
+  // that every step of the evaluation of a residual block is exercised.
+  void BuildProblem(bool batched, int max_batch_size, Problem* problem) {
+    for (int i = 0; i < kNumPoints; ++i) {
+      for (int j = 0; j < kNumCameras; ++j) {
+        auto cost_function = std::make_unique<LinearBatchCostFunction>(
+            1.0 + i * j, 0.1 * i - j, max_batch_size);
+        CostFunction* residual = nullptr;
+        if (batched) {
+          residual = cost_function.release();
+        } else {
+          residual = new UnbatchedCostFunction(std::move(cost_function));
+        }
+        problem->AddResidualBlock(residual,
+                                  (i + j) % 3 == 0 ? new CauchyLoss(1.0)
+                                                   : nullptr,
+                                  points_[i],
+                                  cameras_[j]);
+      }
+    }
+    problem->SetParameterBlockConstant(cameras_[0]);
+    problem->SetManifold(cameras_[1], new SubsetManifold(2, {1}));
+  }
+
+  double points_[kNumPoints][2];
+  double cameras_[kNumCameras][2];
+};
+
+TEST_F(BatchCostFunctionTest, MatchesUnbatchedEvaluation) {
+  for (int max_batch_size : {1, 4, 16}) {
+    for (int num_threads : {1, 4}) {
+      Problem batched_problem;
+      BuildProblem(true, max_batch_size, &batched_problem);
+      Problem unbatched_problem;
+      BuildProblem(false, max_batch_size, &unbatched_problem);
+
+      Problem::EvaluateOptions options;
+      options.num_threads = num_threads;
+
+      double expected_cost;
+      std::vector<double> expected_residuals;
+      std::vector<double> expected_gradient;
+      CRSMatrix expected_jacobian;
+      ASSERT_TRUE(unbatched_problem.Evaluate(options,
+                                             &expected_cost,
+                                             &expected_residuals,
+                                             &expected_gradient,
+                                             &expected_jacobian));
+
+      double cost;
+      std::vector<double> residuals;
+      std::vector<double> gradient;
+      CRSMatrix jacobian;
+      ASSERT_TRUE(batched_problem.Evaluate(
+          options, &cost, &residuals, &gradient, &jacobian));
+
+      // The residuals and the jacobian are computed by the same code, but the
+      // cost and the gradient are summed up in a different order.
+      EXPECT_NEAR(cost, expected_cost, 1e-12 * expected_cost);
+      EXPECT_EQ(residuals, expected_residuals);
+      ASSERT_EQ(gradient.size(), expected_gradient.size());
+      for (int i = 0; i < gradient.size(); ++i) {
+        EXPECT_NEAR(gradient[i], expected_gradient[i], 1e-9);
+      }
+      EXPECT_EQ(jacobian.rows, expected_jacobian.rows);
+      EXPECT_EQ(jacobian.cols, expected_jacobian.cols);
+      EXPECT_EQ(jacobian.values, expected_jacobian.values);
+    }
+  }
+}
+
+TEST_F(BatchCostFunctionTest, GroupsResidualBlocksByType) {
+  Problem problem;
+  BuildProblem(true, 4, &problem);
+  // An unbatched residual block in the middle of the batched ones.
+  problem.AddResidualBlock(
+      new UnbatchedCostFunction(
+          std::make_unique<LinearBatchCostFunction>(1.0, 1.0, 4)),
+      nullptr,
+      points_[0],
+      cameras_[0]);
+  problem.AddResidualBlock(new LinearBatchCostFunction(1.0, 1.0, 4),
+                           nullptr,
+                           points_[1],
+                           cameras_[1]);
+
+  const Program& program = problem.mutable_impl()->program();
+  const ResidualBlockBatches batches = ComputeResidualBlockBatches(program);
+  const int num_residual_blocks = kNumPoints * kNumCameras + 2;
+  const int unbatched_residual_block = num_residual_blocks - 2;
+
+  // The 10 residual blocks of the constant camera go in batches of their own,
+  // separate from the 21 other batched residual blocks.
+  EXPECT_EQ(batches.num_batches(), 3 + 6);
+  EXPECT_EQ(static_cast<int>(batches.residual_blocks.size()),
+            num_residual_blocks - 1);
+  EXPECT_EQ(batches.max_batch_size, 4);
+  ASSERT_EQ(static_cast<int>(batches.first_in_batch.size()),
+            num_residual_blocks);
+  EXPECT_EQ(batches.first_in_batch[unbatched_residual_block],
+            ResidualBlockBatches::kNotBatched);
+
+  std::vector<bool> seen(num_residual_blocks, false);
+  for (int b = 0; b < batches.num_batches(); ++b) {
+    EXPECT_LE(batches.batch_size(b), 4);
+    const int first = batches.residual_blocks[batches.offsets[b]];
+    EXPECT_EQ(batches.first_in_batch[first], b);
+    const bool is_constant =
+        program.residual_blocks()[first]->parameter_blocks()[1]->IsConstant();
+    for (int k = batches.offsets[b]; k < batches.offsets[b + 1]; ++k) {
+      const int i = batches.residual_blocks[k];
+      EXPECT_FALSE(seen[i]);
+      seen[i] = true;
+      EXPECT_EQ(batches.cost_functions[k],
+                program.residual_blocks()[i]->cost_function());
+      EXPECT_EQ(
+          program.residual_blocks()[i]->parameter_blocks()[1]->IsConstant(),
+          is_constant);
+      if (k > batches.offsets[b]) {
+        EXPECT_LT(batches.residual_blocks[k - 1], i);
+        EXPECT_EQ(batches.first_in_batch[i], ResidualBlockBatches::kInBatch);
+      }
+    }
+  }
+}
+
+TEST(ResidualBlockBatches, NoBatchesWithoutBatchCostFunctions) {
+  Problem problem;
+  double x[2] = {1.0, 2.0};
+  double y[2] = {3.0, 4.0};
+  problem.AddResidualBlock(
+      new UnbatchedCostFunction(
+          std::make_unique<LinearBatchCostFunction>(1.0, 1.0, 4)),
+      nullptr,
+      x,
+      y);
+  const ResidualBlockBatches batches =
+      ComputeResidualBlockBatches(problem.mutable_impl()->program());
+  EXPECT_LE(batches.num_batches(), 0);
+  EXPECT_TRUE(batches.first_in_batch.empty());
+}
+
+}  // namespace ceres::internal
@@ -0,0 +1,283 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Benchmarks the evaluation of a synthetic bundle adjustment problem whose
+// reprojection errors are BatchCostFunctions, against the same problem with
+// the reprojection errors hidden behind a plain CostFunction, so that every
+// residual block is evaluated by its own virtual call.
+
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "ceres/batch_cost_function.h"
+#include "ceres/context_impl.h"
+#include "ceres/evaluator.h"
+#include "ceres/internal/eigen.h"
+#include "ceres/problem.h"
+#include "ceres/problem_impl.h"
+#include "ceres/program.h"
+#include "ceres/sparse_matrix.h"
+#include "glog/logging.h"
+
+namespace ceres::internal {
+
+namespace {
+
+constexpr int kNumCameras = 1000;
+constexpr int kNumPoints = 50000;
+constexpr int kNumObservationsPerPoint = 6;
+
+// Projection of point p translated by t with focal length f:
+//
+//   r = f * (p + t).xy / (p + t).z - observation
+//
+// written for the structure of arrays layout of BatchCostFunction, so that
+// the loop over the residual blocks of a batch vectorizes. The camera is
+// [t, f] and the point is p.
+void EvaluateProjections(int n,
+                         const double* observations_x,
+                         const double* observations_y,
+                         double const* const* parameters,
+                         double* residuals,
+                         double** jacobians) {
+  const double* camera = parameters[0];
+  const double* point = parameters[1];
+  for (int k = 0; k < n; ++k) {
+    const double x = point[k] + camera[k];
+    const double y = point[n + k] + camera[n + k];
+    const double z = point[2 * n + k] + camera[2 * n + k];
+    const double f = camera[3 * n + k];
+    const double inv_z = 1.0 / z;
+    const double u = x * inv_z;
+    const double v = y * inv_z;
+    residuals[k] = f * u - observations_x[k];
+    residuals[n + k] = f * v - observations_y[k];
+    if (jacobians == nullptr) {
+      continue;
+    }
+
+    const double f_inv_z = f * inv_z;
+    // Derivatives with respect to x, y and z, which are the same for the
+    // translation and the point.
+    const double dr[2][3] = {{f_inv_z, 0.0, -f_inv_z * u},
+                             {0.0, f_inv_z, -f_inv_z * v}};
+    if (jacobians[0] != nullptr) {
+      for (int r = 0; r < 2; ++r) {
+        for (int c = 0; c < 3; ++c) {
+          jacobians[0][(r * 4 + c) * n + k] = dr[r][c];
+        }
+      }
+      jacobians[0][3 * n + k] = u;
+      jacobians[0][7 * n + k] = v;
+    }
+    if (jacobians[1] != nullptr) {
+      for (int r = 0; r < 2; ++r) {
+        for (int c = 0; c < 3; ++c) {
+          jacobians[1][(r * 3 + c) * n + k] = dr[r][c];
+        }
+      }
+    }
+  }
+}
+
+class BatchProjectionError final : public BatchCostFunction {
+ public:
+  BatchProjectionError(double observation_x, double observation_y)
+      : observation_x_(observation_x), observation_y_(observation_y) {
+    set_num_residuals(2);
+    *mutable_parameter_block_sizes() = {4, 3};
+  }
+
+  bool EvaluateBatch(int batch_size,
+                     const BatchCostFunction* const* cost_functions,
+                     double const* const* parameters,
+                     double* residuals,
+                     double** jacobians) const final {
+    double observations_x[kMaxBatchSize];
+    double observations_y[kMaxBatchSize];
+    CHECK_LE(batch_size, kMaxBatchSize);
+    for (int k = 0; k < batch_size; ++k) {
+      const auto* cost_function =
+          static_cast<const BatchProjectionError*>(cost_functions[k]);
+      observations_x[k] = cost_function->observation_x_;
+      observations_y[k] = cost_function->observation_y_;
+    }
+    EvaluateProjections(batch_size,
+                        observations_x,
+                        observations_y,
+                        parameters,
+                        residuals,
+                        jacobians);
+    return true;
+  }
+
+ private:
+  static constexpr int kMaxBatchSize = 16;
+  double observation_x_;
+  double observation_y_;
+};
+
+// The same cost function, evaluated one residual block at a time.
+class ProjectionError final : public CostFunction {
+ public:
+  ProjectionError(double observation_x, double observation_y)
+      : observation_x_(observation_x), observation_y_(observation_y) {
+    set_num_residuals(2);
+    *mutable_parameter_block_sizes() = {4, 3};
+  }
+
+  bool Evaluate(double const* const* parameters,
+                double* residuals,
+                double** jacobians) const final {
+    EvaluateProjections(
+        1, &observation_x_, &observation_y_, parameters, residuals, jacobians);
+    return true;
+  }
+
+ private:
+  double observation_x_;
+  double observation_y_;
+};
+
+struct ProjectionProblem {
+  explicit ProjectionProblem(bool batched)
+      : cameras(4 * kNumCameras), points(3 * kNumPoints) {
+    std::mt19937 prng;
+    std::uniform_real_distribution<double> uniform(-1.0, 1.0);
+    std::uniform_int_distribution<int> random_camera(0, kNumCameras - 1);
+    for (int i = 0; i < kNumCameras; ++i) {
+      cameras[4 * i + 0] = 0.1 * uniform(prng);
+      cameras[4 * i + 1] = 0.1 * uniform(prng);
+      cameras[4 * i + 2] = 10.0 + uniform(prng);
+      cameras[4 * i + 3] = 500.0;
+    }
+    for (double& coordinate : points) {
+      coordinate = uniform(prng);
+    }
+
+    Problem::Options problem_options;
+    problem_options.enable_fast_removal = false;
+    problem = std::make_unique<Problem>(problem_options);
+    for (int i = 0; i < kNumPoints; ++i) {
+      for (int j = 0; j < kNumObservationsPerPoint; ++j) {
+        const double observation_x = 100.0 * uniform(prng);
+        const double observation_y = 100.0 * uniform(prng);
+        CostFunction* cost_function = nullptr;
+        if (batched) {
+          cost_function =
+              new BatchProjectionError(observation_x, observation_y);
+        } else {
+          cost_function = new ProjectionError(observation_x, observation_y);
+        }
+        problem->AddResidualBlock(cost_function,
+                                  nullptr,
+                                  cameras.data() + 4 * random_camera(prng),
+                                  points.data() + 3 * i);
+      }
+    }
+
+    Program* program = problem->mutable_impl()->mutable_program();
+    parameters.resize(program->NumParameters());
+    program->ParameterBlocksToStateVector(parameters.data());
+  }
+
+  std::vector<double> cameras;
+  std::vector<double> points;
+  std::unique_ptr<Problem> problem;
+  std::vector<double> parameters;
+};
+
+ProjectionProblem* GetProblem(bool batched) {
+  static ProjectionProblem batched_problem(true);
+  static ProjectionProblem unbatched_problem(false);
+  return batched ? &batched_problem : &unbatched_problem;
+}
+
+void Evaluate(benchmark::State& state, bool batched, bool jacobian) {
+  const int num_threads = static_cast<int>(state.range(0));
+  static ContextImpl context;
+  context.EnsureMinimumThreads(num_threads);
+
+  ProjectionProblem* problem = GetProblem(batched);
+  Program* program = problem->problem->mutable_impl()->mutable_program();
+
+  Evaluator::Options options;
+  options.linear_solver_type = ITERATIVE_SCHUR;
+  options.num_threads = num_threads;
+  options.context = &context;
+  options.num_eliminate_blocks = 0;
+  std::string error;
+  auto evaluator = Evaluator::Create(options, program, &error);
+  CHECK(evaluator != nullptr) << error;
+
+  double cost = 0.0;
+  Vector residuals(program->NumResiduals());
+  std::unique_ptr<SparseMatrix> jacobian_matrix;
+  if (jacobian) {
+    jacobian_matrix = evaluator->CreateJacobian();
+  }
+
+  Evaluator::EvaluateOptions evaluate_options;
+  for (auto _ : state) {
+    CHECK(evaluator->Evaluate(evaluate_options,
+                              problem->parameters.data(),
+                              &cost,
+                              residuals.data(),
+                              nullptr,
+                              jacobian_matrix.get()));
+  }
+}
+
+}  // namespace
+
+static void Residuals(benchmark::State& state) {
+  Evaluate(state, false, false);
+}
+BENCHMARK(Residuals)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+static void BatchedResiduals(benchmark::State& state) {
+  Evaluate(state, true, false);
+}
+BENCHMARK(BatchedResiduals)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+static void ResidualsAndJacobian(benchmark::State& state) {
+  Evaluate(state, false, true);
+}
+BENCHMARK(ResidualsAndJacobian)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+static void BatchedResidualsAndJacobian(benchmark::State& state) {
+  Evaluate(state, true, true);
+}
+BENCHMARK(BatchedResidualsAndJacobian)->Arg(1)->Arg(2)->Arg(4)->Arg(8);
+
+}  // namespace ceres::internal
+
+BENCHMARK_MAIN();
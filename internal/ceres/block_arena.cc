@@ -0,0 +1,88 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/block_arena.h"
+
+#include <cstdint>
+#include <memory>
+
+#include "glog/logging.h"
+
+namespace ceres::internal {
+
+BlockArena::BlockArena(int64_t chunk_size) : chunk_size_(chunk_size) {
+  CHECK_GT(chunk_size_, 0);
+}
+
+BlockArena::~BlockArena() = default;
+
+void* BlockArena::Allocate(int64_t size) {
+  CHECK_GT(size, 0);
+  size = RoundUp(size);
+  const int64_t free_list_index = size / kAlignment - 1;
+  if (size <= kMaxReusedSize && free_lists_[free_list_index] != nullptr) {
+    FreeBlock* block = free_lists_[free_list_index];
+    free_lists_[free_list_index] = block->next;
+    return block;
+  }
+
+  if (end_ - next_ < size) {
+    // Allocations larger than a quarter of a chunk get a chunk of their own,
+    // so that the unused memory at the end of the current chunk is not lost.
+    // operator new[] returns memory aligned to at least
+    // alignof(std::max_align_t).
+    if (4 * size > chunk_size_) {
+      chunks_.emplace_back(new char[size]);
+      capacity_ += size;
+      return chunks_.back().get();
+    }
+    chunks_.emplace_back(new char[chunk_size_]);
+    capacity_ += chunk_size_;
+    next_ = chunks_.back().get();
+    end_ = next_ + chunk_size_;
+  }
+
+  void* memory = next_;
+  next_ += size;
+  return memory;
+}
+
+void BlockArena::Free(void* memory, int64_t size) {
+  CHECK(memory != nullptr);
+  size = RoundUp(size);
+  if (size > kMaxReusedSize) {
+    return;
+  }
+  const int64_t free_list_index = size / kAlignment - 1;
+  auto* block = static_cast<FreeBlock*>(memory);
+  block->next = free_lists_[free_list_index];
+  free_lists_[free_list_index] = block;
+}
+
+}  // namespace ceres::internal
@@ -0,0 +1,109 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// An arena which carves the parameter and residual blocks of a problem out of
+// large contiguous chunks of memory.
+
+#ifndef CERES_INTERNAL_BLOCK_ARENA_H_
+#define CERES_INTERNAL_BLOCK_ARENA_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "ceres/internal/disable_warnings.h"
+#include "ceres/internal/export.h"
+
+namespace ceres::internal {
+
+// Objects allocated one after the other from a BlockArena are laid out next to
+// each other in memory, in allocation order, so that iterating over them, as
+// the evaluator does over the residual blocks of a program, touches as few
+// cache lines and pages as possible.
+//
+// Memory is released with Free, and reused by later allocations of the same
+// size, for sizes up to kMaxReusedSize. All the memory of the arena is
+// returned to the system when the arena is destroyed. The arena does not call
+// constructors or destructors, and it is not thread safe.
+class CERES_NO_EXPORT BlockArena {
+ public:
+  // The alignment of all the allocations. It is also the granularity of their
+  // sizes.
+  static constexpr int64_t kAlignment = alignof(std::max_align_t);
+  // Freed blocks larger than this are not reused. This bounds the number of
+  // free lists, which are all created with the arena. Parameter and residual
+  // blocks are well below this size.
+  static constexpr int64_t kMaxReusedSize = 64 * kAlignment;
+
+  explicit BlockArena(int64_t chunk_size = 1 << 20);
+  BlockArena(const BlockArena&) = delete;
+  void operator=(const BlockArena&) = delete;
+  ~BlockArena();
+
+  // Returns size rounded up to a multiple of kAlignment. Objects of this size
+  // can be placed one after the other in a single allocation.
+  static int64_t RoundUp(int64_t size) {
+    return (size + kAlignment - 1) / kAlignment * kAlignment;
+  }
+
+  // Returns memory for size bytes, aligned to kAlignment.
+  void* Allocate(int64_t size);
+
+  // Makes memory, a block of size bytes obtained from Allocate, available for
+  // reuse by later calls to Allocate with the same size, unless size is larger
+  // than kMaxReusedSize. A single allocation can also be returned in multiple
+  // blocks, e.g., if it held an array of objects, as long as the sizes of the
+  // blocks are multiples of kAlignment.
+  void Free(void* memory, int64_t size);
+
+  // The total size of the chunks of memory owned by the arena.
+  int64_t capacity() const { return capacity_; }
+
+ private:
+  struct FreeBlock {
+    FreeBlock* next;
+  };
+
+  const int64_t chunk_size_;
+  std::vector<std::unique_ptr<char[]>> chunks_;
+  int64_t capacity_ = 0;
+  // The unused memory at the end of the last chunk.
+  char* next_ = nullptr;
+  char* end_ = nullptr;
+  // free_lists_[i] is the list of free blocks of size (i + 1) * kAlignment.
+  std::array<FreeBlock*, kMaxReusedSize / kAlignment> free_lists_{};
+};
+
+}  // namespace ceres::internal
+
+#include "ceres/internal/reenable_warnings.h"
+
+#endif  // CERES_INTERNAL_BLOCK_ARENA_H_
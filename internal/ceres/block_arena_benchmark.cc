@@ -0,0 +1,183 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// Benchmarks for the layout of the residual blocks of a synthetic bundle
+// adjustment problem, comparing residual blocks created in a BlockArena, as
+// Problem does, with residual blocks in separate heap allocations interleaved
+// with the allocations of their cost functions. Each iteration evaluates all
+// the residual blocks, in insertion order or in a random order.
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "ceres/block_arena.h"
+#include "ceres/parameter_block.h"
+#include "ceres/residual_block.h"
+#include "ceres/sized_cost_function.h"
+#include "glog/logging.h"
+
+namespace ceres::internal {
+
+namespace {
+
+// A cheap cost function with the parameter block sizes used by the BAL
+// problems, so that the time spent in Evaluate is dominated by the accesses
+// to the residual and parameter blocks.
+class ReprojectionError final : public SizedCostFunction<2, 9, 3> {
+ public:
+  bool Evaluate(double const* const* parameters,
+                double* residuals,
+                double** jacobians) const override {
+    residuals[0] = parameters[0][3] + parameters[1][0] - parameters[1][2];
+    residuals[1] = parameters[0][4] + parameters[1][1] - parameters[1][2];
+    return true;
+  }
+};
+
+// The parameter blocks of a synthetic bundle adjustment problem and its
+// residual blocks, where every point is observed by num_observations_per_point
+// cameras chosen at random. The residual blocks are created in an arena if
+// use_arena is true, and in separate heap allocations otherwise.
+class Scene {
+ public:
+  Scene(int num_cameras,
+        int num_points,
+        int num_observations_per_point,
+        bool use_arena)
+      : cameras_(9 * num_cameras, 1.0), points_(3 * num_points, 1.0) {
+    CHECK_LE(num_observations_per_point, num_cameras);
+    for (int i = 0; i < num_cameras; ++i) {
+      parameter_blocks_.push_back(
+          new (parameter_block_arena_.Allocate(sizeof(ParameterBlock)))
+              ParameterBlock(&cameras_[9 * i], 9, -1));
+    }
+    for (int i = 0; i < num_points; ++i) {
+      parameter_blocks_.push_back(
+          new (parameter_block_arena_.Allocate(sizeof(ParameterBlock)))
+              ParameterBlock(&points_[3 * i], 3, -1));
+    }
+
+    std::mt19937 prng;
+    std::uniform_int_distribution<int> camera_distribution(0,
+                                                           num_cameras - 1);
+    const int64_t memory_size = ResidualBlock::MemorySize(2);
+    for (int i = 0; i < num_points; ++i) {
+      for (int j = 0; j < num_observations_per_point; ++j) {
+        ParameterBlock* parameter_blocks[] = {
+            parameter_blocks_[camera_distribution(prng)],
+            parameter_blocks_[num_cameras + i]};
+        // Users typically allocate a cost function for every residual block,
+        // right before adding it to the problem.
+        cost_functions_.push_back(std::make_unique<ReprojectionError>());
+        void* memory;
+        if (use_arena) {
+          memory = residual_block_arena_.Allocate(memory_size);
+        } else {
+          heap_blocks_.push_back(std::make_unique<char[]>(memory_size));
+          memory = heap_blocks_.back().get();
+        }
+        residual_blocks_.push_back(
+            ResidualBlock::Create(memory,
+                                  cost_functions_.back().get(),
+                                  nullptr,
+                                  parameter_blocks,
+                                  residual_blocks_.size()));
+      }
+    }
+  }
+
+  ~Scene() {
+    for (auto* residual_block : residual_blocks_) {
+      residual_block->~ResidualBlock();
+    }
+    for (auto* parameter_block : parameter_blocks_) {
+      parameter_block->~ParameterBlock();
+    }
+  }
+
+  const std::vector<ResidualBlock*>& residual_blocks() const {
+    return residual_blocks_;
+  }
+
+ private:
+  std::vector<double> cameras_;
+  std::vector<double> points_;
+  BlockArena parameter_block_arena_;
+  BlockArena residual_block_arena_;
+  std::vector<std::unique_ptr<char[]>> heap_blocks_;
+  std::vector<std::unique_ptr<CostFunction>> cost_functions_;
+  std::vector<ParameterBlock*> parameter_blocks_;
+  std::vector<ResidualBlock*> residual_blocks_;
+};
+
+}  // namespace
+
+// The arguments are the number of cameras, points and observations per point,
+// whether the residual blocks are in an arena, and whether they are evaluated
+// in a random order rather than in insertion order.
+static void ResidualBlockEvaluation(benchmark::State& state) {
+  const Scene scene(state.range(0),
+                    state.range(1),
+                    state.range(2),
+                    state.range(3) != 0);
+  std::vector<ResidualBlock*> residual_blocks = scene.residual_blocks();
+  if (state.range(4) != 0) {
+    std::shuffle(
+        residual_blocks.begin(), residual_blocks.end(), std::mt19937());
+  }
+
+  double residuals[2];
+  std::vector<double> scratch(
+      residual_blocks[0]->NumScratchDoublesForEvaluate());
+  for (auto _ : state) {
+    double total_cost = 0.0;
+    for (const auto* residual_block : residual_blocks) {
+      double cost;
+      residual_block->Evaluate(
+          true, &cost, residuals, nullptr, scratch.data());
+      total_cost += cost;
+    }
+    benchmark::DoNotOptimize(total_cost);
+  }
+}
+
+BENCHMARK(ResidualBlockEvaluation)
+    ->ArgNames({"cameras", "points", "obs", "arena", "shuffled"})
+    ->ArgsProduct({{257}, {65132}, {3}, {0, 1}, {0, 1}})
+    ->ArgsProduct({{1778}, {993923}, {5}, {0, 1}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace ceres::internal
+
+BENCHMARK_MAIN();
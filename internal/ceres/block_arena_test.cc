@@ -0,0 +1,126 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/block_arena.h"
+
+#include <cstdint>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ceres::internal {
+
+namespace {
+
+bool IsAligned(const void* memory) {
+  return reinterpret_cast<uintptr_t>(memory) % BlockArena::kAlignment == 0;
+}
+
+}  // namespace
+
+TEST(BlockArena, RoundUp) {
+  EXPECT_EQ(BlockArena::RoundUp(1), BlockArena::kAlignment);
+  EXPECT_EQ(BlockArena::RoundUp(BlockArena::kAlignment),
+            BlockArena::kAlignment);
+  EXPECT_EQ(BlockArena::RoundUp(BlockArena::kAlignment + 1),
+            2 * BlockArena::kAlignment);
+}
+
+TEST(BlockArena, ConsecutiveAllocationsAreContiguousAndAligned) {
+  BlockArena arena(1024);
+  char* previous = static_cast<char*>(arena.Allocate(40));
+  EXPECT_TRUE(IsAligned(previous));
+  for (int i = 0; i < 5; ++i) {
+    char* memory = static_cast<char*>(arena.Allocate(40));
+    EXPECT_TRUE(IsAligned(memory));
+    EXPECT_EQ(memory, previous + BlockArena::RoundUp(40));
+    previous = memory;
+  }
+  EXPECT_EQ(arena.capacity(), 1024);
+}
+
+TEST(BlockArena, FreedMemoryIsReused) {
+  BlockArena arena(1024);
+  void* a = arena.Allocate(24);
+  void* b = arena.Allocate(24);
+  arena.Free(a, 24);
+  arena.Free(b, 24);
+  EXPECT_EQ(arena.Allocate(24), b);
+  EXPECT_EQ(arena.Allocate(24), a);
+  // Blocks of a different size are not reused.
+  void* c = arena.Allocate(100);
+  EXPECT_NE(c, a);
+  EXPECT_NE(c, b);
+}
+
+TEST(BlockArena, LargeFreedBlocksAreNotReused) {
+  BlockArena arena(1 << 16);
+  const int64_t size = BlockArena::kMaxReusedSize + BlockArena::kAlignment;
+  char* memory = static_cast<char*>(arena.Allocate(size));
+  arena.Free(memory, size);
+  EXPECT_EQ(arena.Allocate(size), memory + size);
+
+  // The largest reused size is still reused.
+  memory = static_cast<char*>(arena.Allocate(BlockArena::kMaxReusedSize));
+  arena.Free(memory, BlockArena::kMaxReusedSize);
+  EXPECT_EQ(arena.Allocate(BlockArena::kMaxReusedSize), memory);
+}
+
+TEST(BlockArena, PartsOfAnAllocationCanBeFreedSeparately) {
+  BlockArena arena(1024);
+  const int64_t size = BlockArena::RoundUp(24);
+  char* memory = static_cast<char*>(arena.Allocate(3 * size));
+  arena.Free(memory + size, size);
+  arena.Free(memory, size);
+  EXPECT_EQ(arena.Allocate(size), memory);
+  EXPECT_EQ(arena.Allocate(size), memory + size);
+}
+
+TEST(BlockArena, LargeAllocationsGetTheirOwnChunk) {
+  BlockArena arena(1024);
+  char* small = static_cast<char*>(arena.Allocate(16));
+  EXPECT_EQ(arena.capacity(), 1024);
+  void* large = arena.Allocate(4096);
+  EXPECT_TRUE(IsAligned(large));
+  EXPECT_EQ(arena.capacity(), 1024 + 4096);
+  // The rest of the first chunk is still used.
+  EXPECT_EQ(arena.Allocate(16), small + BlockArena::RoundUp(16));
+}
+
+TEST(BlockArena, NewChunksAreAllocatedWhenFull) {
+  BlockArena arena(256);
+  std::vector<void*> blocks;
+  for (int i = 0; i < 64; ++i) {
+    blocks.push_back(arena.Allocate(32));
+    EXPECT_TRUE(IsAligned(blocks.back()));
+  }
+  EXPECT_EQ(arena.capacity(), 64 * 32 / 256 * 256);
+}
+
+}  // namespace ceres::internal
@@ -44,7 +44,9 @@ BlockRandomAccessDenseMatrix::BlockRandomAccessDenseMatrix(
     : blocks_(std::move(blocks)), context_(context), num_threads_(num_threads) {
   const int num_blocks = blocks_.size();
   num_rows_ = NumScalarEntries(blocks_);
-  values_ = std::make_unique<double[]>(num_rows_ * num_rows_);
+  // Values are left uninitialized and zeroed by SetZero in parallel, so that
+  // they are first touched by the threads which are going to update them.
+  values_ = std::unique_ptr<double[]>(new double[num_rows_ * num_rows_]);
   cell_infos_ = std::make_unique<CellInfo[]>(num_blocks * num_blocks);
   for (int i = 0; i < num_blocks * num_blocks; ++i) {
     cell_infos_[i].values = values_.get();
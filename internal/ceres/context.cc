@@ -36,6 +36,9 @@ namespace ceres {
 
 Context::Context() = default;
 Context* Context::Create() { return new internal::ContextImpl(); }
+Context* Context::Create(const Options& options) {
+  return new internal::ContextImpl(options);
+}
 Context::~Context() = default;
 
 }  // namespace ceres
@@ -46,6 +46,10 @@ namespace ceres::internal {
 
 ContextImpl::ContextImpl() = default;
 
+ContextImpl::ContextImpl(const Context::Options& options) {
+  thread_pool.SetThreadPinning(options.pin_threads);
+}
+
 #ifndef CERES_NO_CUDA
 void ContextImpl::TearDown() {
   if (cusolver_handle_ != nullptr) {
@@ -56,6 +56,7 @@ namespace ceres::internal {
 class CERES_NO_EXPORT ContextImpl final : public Context {
  public:
   ContextImpl();
+  explicit ContextImpl(const Context::Options& options);
   ~ContextImpl() override;
   ContextImpl(const ContextImpl&) = delete;
   void operator=(const ContextImpl&) = delete;
@@ -644,6 +644,25 @@ void DoglegStrategy::StepIsInvalid() {
 
 double DoglegStrategy::Radius() const { return radius_; }
 
+bool DoglegStrategy::Reset(const TrustRegionStrategy::Options& options) {
+  if (options.trust_region_strategy_type != DOGLEG) {
+    return false;
+  }
+  CHECK_EQ(linear_solver_, options.linear_solver);
+  radius_ = options.initial_radius;
+  max_radius_ = options.max_radius;
+  min_diagonal_ = options.min_lm_diagonal;
+  max_diagonal_ = options.max_lm_diagonal;
+  mu_ = min_mu_;
+  dogleg_step_norm_ = 0.0;
+  reuse_ = false;
+  dogleg_type_ = options.dogleg_type;
+  CHECK_GT(min_diagonal_, 0.0);
+  CHECK_LE(min_diagonal_, max_diagonal_);
+  CHECK_GT(max_radius_, 0.0);
+  return true;
+}
+
 bool DoglegStrategy::ComputeSubspaceModel(SparseMatrix* jacobian) {
   // Compute an orthogonal basis for the subspace using QR decomposition.
   Matrix basis_vectors(jacobian->num_cols(), 2);
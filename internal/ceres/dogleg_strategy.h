@@ -66,6 +66,7 @@ class CERES_NO_EXPORT DoglegStrategy final : public TrustRegionStrategy {
   void StepRejected(double step_quality) final;
   void StepIsInvalid() override;
   double Radius() const final;
+  bool Reset(const TrustRegionStrategy::Options& options) final;
 
   // These functions are predominantly for testing.
   Vector gradient() const { return gradient_; }
@@ -95,10 +96,10 @@ class CERES_NO_EXPORT DoglegStrategy final : public TrustRegionStrategy {
 
   LinearSolver* linear_solver_;
   double radius_;
-  const double max_radius_;
+  double max_radius_;
 
-  const double min_diagonal_;
-  const double max_diagonal_;
+  double min_diagonal_;
+  double max_diagonal_;
 
   // mu is used to scale the diagonal matrix used to make the
   // Gauss-Newton solve full rank. In each solve, the strategy starts
@@ -36,6 +36,7 @@
 #include "benchmark/benchmark.h"
 #include "ceres/block_sparse_matrix.h"
 #include "ceres/bundle_adjustment_test_util.h"
+#include "ceres/context_impl.h"
 #include "ceres/cuda_block_sparse_crs_view.h"
 #include "ceres/cuda_partitioned_block_sparse_crs_view.h"
 #include "ceres/cuda_sparse_matrix.h"
@@ -803,6 +804,13 @@ int main(int argc, char** argv) {
   context.InitCuda(&message);
 #endif
 
+  // Context with worker threads pinned to cpus, in order to evaluate the
+  // effect of NUMA-aware placement of threads and memory.
+  ceres::Context::Options pinned_context_options;
+  pinned_context_options.pin_threads = true;
+  ceres::internal::ContextImpl pinned_context(pinned_context_options);
+  pinned_context.EnsureMinimumThreads(16);
+
   for (int i = 1; i < argc; ++i) {
     const std::string path(argv[i]);
     const std::string name_residuals = "Residuals<" + path + ">";
@@ -828,6 +836,30 @@ int main(int argc, char** argv) {
         ->Arg(8)
         ->Arg(16);
 
+    const std::string name_residuals_pinned =
+        "ResidualsPinnedThreads<" + path + ">";
+    ::benchmark::RegisterBenchmark(name_residuals_pinned.c_str(),
+                                   ceres::internal::Residuals,
+                                   data,
+                                   &pinned_context)
+        ->Arg(1)
+        ->Arg(2)
+        ->Arg(4)
+        ->Arg(8)
+        ->Arg(16);
+
+    const std::string name_jacobians_pinned =
+        "ResidualsAndJacobianPinnedThreads<" + path + ">";
+    ::benchmark::RegisterBenchmark(name_jacobians_pinned.c_str(),
+                                   ceres::internal::ResidualsAndJacobian,
+                                   data,
+                                   &pinned_context)
+        ->Arg(1)
+        ->Arg(2)
+        ->Arg(4)
+        ->Arg(8)
+        ->Arg(16);
+
     const std::string name_plus = "Plus<" + path + ">";
     ::benchmark::RegisterBenchmark(
         name_plus.c_str(), ceres::internal::Plus, data, &context)
@@ -171,4 +171,24 @@ void LevenbergMarquardtStrategy::StepRejected(double /*step_quality*/) {
 
 double LevenbergMarquardtStrategy::Radius() const { return radius_; }
 
+bool LevenbergMarquardtStrategy::Reset(
+    const TrustRegionStrategy::Options& options) {
+  if (options.trust_region_strategy_type != LEVENBERG_MARQUARDT) {
+    return false;
+  }
+  CHECK_EQ(linear_solver_, options.linear_solver);
+  CHECK_EQ(context_, options.context);
+  CHECK_EQ(num_threads_, options.num_threads);
+  radius_ = options.initial_radius;
+  max_radius_ = options.max_radius;
+  min_diagonal_ = options.min_lm_diagonal;
+  max_diagonal_ = options.max_lm_diagonal;
+  decrease_factor_ = 2.0;
+  reuse_diagonal_ = false;
+  CHECK_GT(min_diagonal_, 0.0);
+  CHECK_LE(min_diagonal_, max_diagonal_);
+  CHECK_GT(max_radius_, 0.0);
+  return true;
+}
+
 }  // namespace ceres::internal
@@ -69,13 +69,14 @@ class CERES_NO_EXPORT LevenbergMarquardtStrategy final
   }
 
   double Radius() const final;
+  bool Reset(const TrustRegionStrategy::Options& options) final;
 
  private:
   LinearSolver* linear_solver_;
   double radius_;
   double max_radius_;
-  const double min_diagonal_;
-  const double max_diagonal_;
+  double min_diagonal_;
+  double max_diagonal_;
   double decrease_factor_;
   bool reuse_diagonal_;
   Vector diagonal_;  // diagonal_ =  diag(J'J)
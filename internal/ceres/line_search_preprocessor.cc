@@ -101,4 +101,20 @@ bool LineSearchPreprocessor::Preprocess(const Solver::Options& options,
   return true;
 }
 
+bool LineSearchPreprocessor::Rebind(const Solver::Options& options,
+                                    PreprocessedProblem* pp) {
+  CHECK(pp != nullptr);
+  if (!IsProgramValid(pp->problem->program(), &pp->error) ||
+      !RebindCommon(options, pp)) {
+    return false;
+  }
+
+  if (pp->reduced_program->NumParameterBlocks() == 0) {
+    return true;
+  }
+
+  SetupCommonMinimizerOptions(pp);
+  return true;
+}
+
 }  // namespace ceres::internal
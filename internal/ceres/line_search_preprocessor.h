@@ -42,6 +42,8 @@ class CERES_NO_EXPORT LineSearchPreprocessor final : public Preprocessor {
   bool Preprocess(const Solver::Options& options,
                   ProblemImpl* problem,
                   PreprocessedProblem* preprocessed_problem) final;
+  bool Rebind(const Solver::Options& options,
+              PreprocessedProblem* preprocessed_problem) final;
 };
 
 }  // namespace ceres::internal
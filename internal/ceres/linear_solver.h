@@ -159,6 +159,7 @@ class CERES_NO_EXPORT LinearSolver {
     // See solver.h for information about these flags.
     bool dynamic_sparsity = false;
     bool use_explicit_schur_complement = false;
+    bool use_lock_free_schur_elimination = false;
 
     // Number of internal iterations that the solver uses. This
     // parameter only makes sense for iterative solvers like CG.
@@ -26,10 +26,16 @@
 // ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
 // POSSIBILITY OF SUCH DAMAGE.
 
+#include <functional>
+#include <thread>
+#include <vector>
+
 #include "benchmark/benchmark.h"
+#include "ceres/concurrent_queue.h"
 #include "ceres/context_impl.h"
 #include "ceres/internal/eigen.h"
 #include "ceres/parallel_for.h"
+#include "ceres/thread_pool.h"
 #include "glog/logging.h"
 
 namespace ceres::internal {
@@ -55,21 +61,111 @@ BENCHMARK(SchedulerBenchmark)
     ->Args({128, 4})
     ->Args({128, 8})
     ->Args({128, 16})
+    ->Args({128, 32})
+    ->Args({128, 64})
     ->Args({256, 1})
     ->Args({256, 2})
     ->Args({256, 4})
     ->Args({256, 8})
     ->Args({256, 16})
+    ->Args({256, 32})
+    ->Args({256, 64})
     ->Args({1024, 1})
     ->Args({1024, 2})
     ->Args({1024, 4})
     ->Args({1024, 8})
     ->Args({1024, 16})
+    ->Args({1024, 32})
+    ->Args({1024, 64})
     ->Args({4096, 1})
     ->Args({4096, 2})
     ->Args({4096, 4})
     ->Args({4096, 8})
-    ->Args({4096, 16});
+    ->Args({4096, 16})
+    ->Args({4096, 32})
+    ->Args({4096, 64});
+
+// Thread pool with a single task queue shared by all of the workers, which was
+// used by Ceres prior to the work-stealing ThreadPool.  Serves as a baseline.
+class SharedQueueThreadPool {
+ public:
+  explicit SharedQueueThreadPool(int num_threads) {
+    for (int i = 0; i < num_threads; ++i) {
+      threads_.emplace_back([this]() {
+        std::function<void()> task;
+        while (task_queue_.Wait(&task)) {
+          task();
+        }
+      });
+    }
+  }
+
+  ~SharedQueueThreadPool() {
+    task_queue_.StopWaiters();
+    for (auto& thread : threads_) {
+      thread.join();
+    }
+  }
+
+  void AddTask(const std::function<void()>& func) { task_queue_.Push(func); }
+
+ private:
+  ConcurrentQueue<std::function<void()>> task_queue_;
+  std::vector<std::thread> threads_;
+};
+
+// A task that enqueues its successor before doing its own (empty) work, which
+// mimics the scheduling pattern of ParallelFor.
+template <typename ThreadPoolType>
+struct ChainedTask {
+  void operator()() const {
+    if (num_remaining_tasks > 1) {
+      thread_pool->AddTask(ChainedTask{
+          thread_pool, block_until_finished, num_remaining_tasks - 1});
+    }
+    block_until_finished->Finished(1);
+  }
+
+  ThreadPoolType* thread_pool;
+  BlockUntilFinished* block_until_finished;
+  int num_remaining_tasks;
+};
+
+// Throughput of task scheduling: num_threads chains of tasks are started from
+// the main thread, with all subsequent tasks being added by the workers.
+template <typename ThreadPoolType>
+static void ThreadPoolTaskBenchmark(benchmark::State& state) {
+  const int num_threads = static_cast<int>(state.range(0));
+  constexpr int kNumTasksPerThread = 1024;
+  ThreadPoolType thread_pool(num_threads);
+
+  for (auto _ : state) {
+    BlockUntilFinished block_until_finished(num_threads * kNumTasksPerThread);
+    for (int i = 0; i < num_threads; ++i) {
+      thread_pool.AddTask(ChainedTask<ThreadPoolType>{
+          &thread_pool, &block_until_finished, kNumTasksPerThread});
+    }
+    block_until_finished.Block();
+  }
+  state.SetItemsProcessed(state.iterations() * num_threads *
+                          kNumTasksPerThread);
+}
+BENCHMARK_TEMPLATE(ThreadPoolTaskBenchmark, SharedQueueThreadPool)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
+BENCHMARK_TEMPLATE(ThreadPoolTaskBenchmark, ThreadPool)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16)
+    ->Arg(32)
+    ->Arg(64);
 
 }  // namespace ceres::internal
 
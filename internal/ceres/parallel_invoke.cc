@@ -34,7 +34,9 @@
 #include <condition_variable>
 #include <memory>
 #include <mutex>
+#include <new>
 #include <tuple>
+#include <vector>
 
 #include "ceres/internal/config.h"
 #include "ceres/parallel_for.h"
@@ -72,6 +74,48 @@ ParallelInvokeState::ParallelInvokeState(int start,
       num_base_p1_sized_blocks((end - start) % num_work_blocks),
       block_id(0),
       thread_id(0),
-      block_until_finished(num_work_blocks) {}
+      block_until_finished(num_work_blocks),
+      num_references(1) {}
+
+namespace {
+
+// Memory of ParallelInvokeStates whose last reference was dropped. It is never
+// destroyed, since tasks may still drop references during static destruction.
+struct ParallelInvokeStateFreeList {
+  std::mutex mutex;
+  std::vector<void*> states;
+};
+
+ParallelInvokeStateFreeList& FreeList() {
+  static auto* free_list = new ParallelInvokeStateFreeList;
+  return *free_list;
+}
+
+}  // namespace
+
+ParallelInvokeStateRef::ParallelInvokeStateRef(int start,
+                                               int end,
+                                               int num_work_blocks) {
+  void* memory = nullptr;
+  {
+    ParallelInvokeStateFreeList& free_list = FreeList();
+    std::lock_guard<std::mutex> lock(free_list.mutex);
+    if (!free_list.states.empty()) {
+      memory = free_list.states.back();
+      free_list.states.pop_back();
+    }
+  }
+  if (memory == nullptr) {
+    memory = ::operator new(sizeof(ParallelInvokeState));
+  }
+  state_ = new (memory) ParallelInvokeState(start, end, num_work_blocks);
+}
+
+void ParallelInvokeStateRef::Recycle(ParallelInvokeState* state) {
+  state->~ParallelInvokeState();
+  ParallelInvokeStateFreeList& free_list = FreeList();
+  std::lock_guard<std::mutex> lock(free_list.mutex);
+  free_list.states.push_back(state);
+}
 
 }  // namespace ceres::internal
@@ -38,6 +38,7 @@
 #include <mutex>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 
 namespace ceres::internal {
 
@@ -141,6 +142,41 @@ struct ParallelInvokeState {
 
   // Used to signal when all the work has been completed.  Thread safe.
   BlockUntilFinished block_until_finished;
+
+  // Number of ParallelInvokeStateRefs pointing to this state.
+  std::atomic<int> num_references;
+};
+
+// A reference counted handle to a ParallelInvokeState, used like a
+// std::shared_ptr. The states are not allocated for every call of
+// ParallelInvoke, instead they are recycled through a process-wide free list
+// when their last reference is dropped. Once the free list holds as many
+// states as there are concurrent ParallelInvoke calls, ParallelInvoke no
+// longer allocates memory.
+class ParallelInvokeStateRef {
+ public:
+  ParallelInvokeStateRef(int start, int end, int num_work_blocks);
+  ParallelInvokeStateRef(const ParallelInvokeStateRef& other) noexcept
+      : state_(other.state_) {
+    state_->num_references.fetch_add(1, std::memory_order_relaxed);
+  }
+  ParallelInvokeStateRef(ParallelInvokeStateRef&& other) noexcept
+      : state_(std::exchange(other.state_, nullptr)) {}
+  ParallelInvokeStateRef& operator=(const ParallelInvokeStateRef&) = delete;
+  ParallelInvokeStateRef& operator=(ParallelInvokeStateRef&&) = delete;
+  ~ParallelInvokeStateRef() {
+    if (state_ != nullptr &&
+        state_->num_references.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      Recycle(state_);
+    }
+  }
+
+  ParallelInvokeState* operator->() const { return state_; }
+
+ private:
+  static void Recycle(ParallelInvokeState* state);
+
+  ParallelInvokeState* state_;
 };
 
 // This implementation uses a fixed size max worker pool with a shared task
@@ -161,6 +197,8 @@ struct ParallelInvokeState {
 //
 // A performance analysis has shown this implementation is on par with OpenMP
 // and TBB.
+//
+// context must not be null; ParallelFor, the only caller, checks it.
 template <typename F>
 void ParallelInvoke(ContextImpl* context,
                     int start,
@@ -168,8 +206,6 @@ void ParallelInvoke(ContextImpl* context,
                     int num_threads,
                     F&& function,
                     int min_block_size) {
-  CHECK(context != nullptr);
-
   // Maximal number of work items scheduled for a single thread
   //  - Lower number of work items results in larger runtimes on unequal tasks
   //  - Higher number of work items results in larger losses for synchronization
@@ -183,11 +219,10 @@ void ParallelInvoke(ContextImpl* context,
   const int num_work_blocks = std::min((end - start) / min_block_size,
                                        num_threads * kWorkBlocksPerThread);
 
-  // We use a std::shared_ptr because the main thread can finish all
-  // the work before the tasks have been popped off the queue.  So the
+  // The shared state is reference counted because the main thread can finish
+  // all the work before the tasks have been popped off the queue.  So the
   // shared state needs to exist for the duration of all the tasks.
-  auto shared_state =
-      std::make_shared<ParallelInvokeState>(start, end, num_work_blocks);
+  ParallelInvokeStateRef shared_state(start, end, num_work_blocks);
 
   // A function which tries to schedule another task in the thread pool and
   // perform several chunks of work. Function expects itself as the argument in
@@ -207,11 +242,11 @@ void ParallelInvoke(ContextImpl* context,
     if (thread_id + 1 < num_threads &&
         shared_state->block_id < num_work_blocks) {
       // Add another thread to the thread pool.
-      // Note we are taking the task as value so the copy of shared_state shared
-      // pointer (captured by value at declaration of task lambda-function) is
-      // copied and the ref count is increased. This is to prevent it from being
-      // deleted when the main thread finishes all the work and exits before the
-      // threads finish.
+      // Note we are taking the task as value so the copy of shared_state
+      // reference (captured by value at declaration of task lambda-function)
+      // is copied and the ref count is increased. This is to prevent it from
+      // being recycled when the main thread finishes all the work and exits
+      // before the threads finish.
       context->thread_pool.AddTask([task_copy]() { task_copy(task_copy); });
     }
 
@@ -37,13 +37,13 @@
 #include <limits>
 #include <memory>
 #include <string>
-#include <unordered_set>
 
 #include "ceres/array_utils.h"
 #include "ceres/internal/disable_warnings.h"
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/export.h"
 #include "ceres/manifold.h"
+#include "ceres/pointer_hash_map.h"
 #include "ceres/stringprintf.h"
 #include "glog/logging.h"
 
@@ -63,7 +63,7 @@ class ResidualBlock;
 // proper disposal of the manifold.
 class CERES_NO_EXPORT ParameterBlock {
  public:
-  using ResidualBlockSet = std::unordered_set<ResidualBlock*>;
+  using ResidualBlockSet = PointerHashSet<ResidualBlock*>;
 
   // Create a parameter block with the user state, size, and index specified.
   // The size is the size of the parameter block and the index is the position
@@ -0,0 +1,158 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/parameter_block_aliasing.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "glog/logging.h"
+
+namespace ceres::internal {
+
+namespace {
+
+// Pointers to unrelated objects are compared with std::less, which defines a
+// total order on them.
+bool Less(const double* a, const double* b) {
+  return std::less<const double*>()(a, b);
+}
+
+}  // namespace
+
+void ParameterBlockAliasing::Insert(double* values, int size) {
+  CHECK(values != nullptr);
+  CHECK_GT(size, 0);
+  // The vectors of the runs are kept when the runs are merged, so that their
+  // memory is reused.
+  if (num_runs_ == runs_.size()) {
+    runs_.emplace_back();
+  }
+  Run& run = runs_[num_runs_++];
+  run.clear();
+  run.push_back({values, size});
+  ++num_regions_;
+
+  while (num_runs_ > 1 &&
+         runs_[num_runs_ - 2].size() < 2 * runs_[num_runs_ - 1].size()) {
+    MergeLastRuns();
+  }
+}
+
+void ParameterBlockAliasing::Erase(double* values) {
+  for (int i = 0; i < num_runs_; ++i) {
+    Run& run = runs_[i];
+    auto it = std::lower_bound(
+        run.begin(), run.end(), values, [](const Region& region, double* v) {
+          return Less(region.values, v);
+        });
+    for (; it != run.end() && it->values == values; ++it) {
+      if (it->size == 0) {
+        continue;
+      }
+      it->size = 0;
+      ++num_erased_regions_;
+      if (2 * num_erased_regions_ > num_regions_) {
+        while (num_runs_ > 1) {
+          MergeLastRuns();
+        }
+        RemoveErasedRegions(&runs_[0]);
+      }
+      return;
+    }
+  }
+}
+
+bool ParameterBlockAliasing::FindAliasedRegion(const double* values,
+                                               int size,
+                                               double** aliased_values,
+                                               int* aliased_size) const {
+  CHECK(aliased_values != nullptr);
+  CHECK(aliased_size != nullptr);
+  const double* end = values + size;
+  for (int i = 0; i < num_runs_; ++i) {
+    const Run& run = runs_[i];
+    // The live regions of a run do not overlap, so the last live region which
+    // starts before end is also the one which ends last.
+    auto it = std::lower_bound(
+        run.begin(),
+        run.end(),
+        end,
+        [](const Region& region, const double* v) {
+          return Less(region.values, v);
+        });
+    while (it != run.begin()) {
+      --it;
+      if (it->size == 0) {
+        continue;
+      }
+      if (Less(values, it->values + it->size)) {
+        *aliased_values = it->values;
+        *aliased_size = it->size;
+        return true;
+      }
+      break;
+    }
+  }
+  return false;
+}
+
+void ParameterBlockAliasing::MergeLastRuns() {
+  CHECK_GT(num_runs_, 1);
+  Run& first = runs_[num_runs_ - 2];
+  Run& second = runs_[num_runs_ - 1];
+  const int64_t middle = first.size();
+  first.insert(first.end(), second.begin(), second.end());
+  std::inplace_merge(first.begin(),
+                     first.begin() + middle,
+                     first.end(),
+                     [](const Region& a, const Region& b) {
+                       return Less(a.values, b.values);
+                     });
+  second.clear();
+  --num_runs_;
+  RemoveErasedRegions(&first);
+}
+
+void ParameterBlockAliasing::RemoveErasedRegions(Run* run) {
+  const int64_t size = run->size();
+  run->erase(std::remove_if(run->begin(),
+                            run->end(),
+                            [](const Region& region) {
+                              return region.size == 0;
+                            }),
+             run->end());
+  const int64_t num_removed = size - run->size();
+  num_regions_ -= num_removed;
+  num_erased_regions_ -= num_removed;
+}
+
+}  // namespace ceres::internal
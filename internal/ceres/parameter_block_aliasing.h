@@ -0,0 +1,101 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// Detection of overlapping memory between the parameter blocks of a problem.
+
+#ifndef CERES_INTERNAL_PARAMETER_BLOCK_ALIASING_H_
+#define CERES_INTERNAL_PARAMETER_BLOCK_ALIASING_H_
+
+#include <cstdint>
+#include <vector>
+
+#include "ceres/internal/disable_warnings.h"
+#include "ceres/internal/export.h"
+
+namespace ceres::internal {
+
+// The set of memory regions of the parameter blocks of a problem, which
+// answers whether a new parameter block would alias one of them.
+//
+// The regions are stored in sorted runs of decreasing size, where each run is
+// at least twice as large as the next one, so there are O(log n) runs. A new
+// region is added as a run of its own, and runs are merged like the digits of
+// a binary counter. Insertions therefore move O(log n) regions amortized and
+// do not allocate a node per region, as an ordered tree like std::set does,
+// and queries take O(log^2 n) comparisons over contiguous memory.
+//
+// Removed regions are marked as empty, and dropped when their run is merged
+// or when they make up half of the regions, in which case all the runs are
+// merged into one.
+class CERES_NO_EXPORT ParameterBlockAliasing {
+ public:
+  // Adds the region of size doubles starting at values, which must not alias
+  // any of the regions in the set.
+  void Insert(double* values, int size);
+
+  // Removes the region starting at values. Does nothing if there is no such
+  // region.
+  void Erase(double* values);
+
+  // Returns true if the region of size doubles starting at values overlaps
+  // one of the regions in the set, and stores the first one found in
+  // aliased_values and aliased_size.
+  bool FindAliasedRegion(const double* values,
+                         int size,
+                         double** aliased_values,
+                         int* aliased_size) const;
+
+  // The number of regions in the set.
+  int64_t size() const { return num_regions_ - num_erased_regions_; }
+
+ private:
+  struct Region {
+    double* values;
+    // Zero if the region was erased.
+    int size;
+  };
+  using Run = std::vector<Region>;
+
+  // Merges the last two runs, dropping the erased regions.
+  void MergeLastRuns();
+  void RemoveErasedRegions(Run* run);
+
+  // runs_[0, num_runs_) are the runs. The remaining vectors are kept for the
+  // memory they own.
+  std::vector<Run> runs_;
+  int num_runs_ = 0;
+  int64_t num_regions_ = 0;
+  int64_t num_erased_regions_ = 0;
+};
+
+}  // namespace ceres::internal
+
+#include "ceres/internal/reenable_warnings.h"
+
+#endif  // CERES_INTERNAL_PARAMETER_BLOCK_ALIASING_H_
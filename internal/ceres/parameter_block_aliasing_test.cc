@@ -0,0 +1,157 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/parameter_block_aliasing.h"
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "gtest/gtest.h"
+
+namespace ceres::internal {
+
+namespace {
+
+double* IntToPtr(uintptr_t i) {
+  return reinterpret_cast<double*>(sizeof(double) * i);  // NOLINT
+}
+
+}  // namespace
+
+TEST(ParameterBlockAliasing, FindsOverlappingRegions) {
+  // Layout is
+  //
+  //   0  1  2  3  4  5  6  7  8  9 10 11 12 13 14 15 16 17
+  //                 [x] x  x  x  x          [y] y  y
+  ParameterBlockAliasing aliasing;
+  aliasing.Insert(IntToPtr(5), 5);
+  aliasing.Insert(IntToPtr(13), 3);
+  EXPECT_EQ(aliasing.size(), 2);
+
+  double* aliased_values = nullptr;
+  int aliased_size = 0;
+  EXPECT_TRUE(aliasing.FindAliasedRegion(
+      IntToPtr(4), 2, &aliased_values, &aliased_size));
+  EXPECT_EQ(aliased_values, IntToPtr(5));
+  EXPECT_EQ(aliased_size, 5);
+  EXPECT_TRUE(aliasing.FindAliasedRegion(
+      IntToPtr(8), 3, &aliased_values, &aliased_size));
+  EXPECT_EQ(aliased_values, IntToPtr(5));
+  EXPECT_TRUE(aliasing.FindAliasedRegion(
+      IntToPtr(12), 2, &aliased_values, &aliased_size));
+  EXPECT_EQ(aliased_values, IntToPtr(13));
+  EXPECT_EQ(aliased_size, 3);
+  EXPECT_TRUE(aliasing.FindAliasedRegion(
+      IntToPtr(0), 18, &aliased_values, &aliased_size));
+
+  EXPECT_FALSE(aliasing.FindAliasedRegion(
+      IntToPtr(2), 3, &aliased_values, &aliased_size));
+  EXPECT_FALSE(aliasing.FindAliasedRegion(
+      IntToPtr(10), 3, &aliased_values, &aliased_size));
+  EXPECT_FALSE(aliasing.FindAliasedRegion(
+      IntToPtr(16), 2, &aliased_values, &aliased_size));
+}
+
+TEST(ParameterBlockAliasing, ErasedRegionsDoNotAlias) {
+  ParameterBlockAliasing aliasing;
+  aliasing.Insert(IntToPtr(5), 5);
+  aliasing.Insert(IntToPtr(13), 3);
+  aliasing.Erase(IntToPtr(5));
+  // Erasing a region which is not in the set does nothing.
+  aliasing.Erase(IntToPtr(6));
+  EXPECT_EQ(aliasing.size(), 1);
+
+  double* aliased_values = nullptr;
+  int aliased_size = 0;
+  EXPECT_FALSE(aliasing.FindAliasedRegion(
+      IntToPtr(4), 9, &aliased_values, &aliased_size));
+  aliasing.Insert(IntToPtr(4), 9);
+  EXPECT_TRUE(aliasing.FindAliasedRegion(
+      IntToPtr(12), 1, &aliased_values, &aliased_size));
+  EXPECT_EQ(aliased_values, IntToPtr(4));
+  EXPECT_EQ(aliased_size, 9);
+}
+
+// Compares against a brute force search over randomly inserted and erased
+// regions, which exercises the merging of the runs.
+TEST(ParameterBlockAliasing, MatchesBruteForce) {
+  constexpr int kNumSlots = 1000;
+  constexpr int kSlotSize = 4;
+  std::mt19937 prng;
+  std::uniform_int_distribution<int> slot_distribution(0, kNumSlots - 1);
+  std::uniform_int_distribution<int> size_distribution(1, kSlotSize);
+  std::uniform_int_distribution<int> offset_distribution(0, 2 * kSlotSize);
+
+  // Every slot holds at most one region, of size at most kSlotSize, so the
+  // regions in the set never alias. Slot i starts at kSlotSize * (i + 1), so
+  // that no region starts at the null pointer.
+  auto slot_start = [](int slot) { return kSlotSize * (slot + 1); };
+  std::vector<int> sizes(kNumSlots, 0);
+  ParameterBlockAliasing aliasing;
+  int num_regions = 0;
+  for (int i = 0; i < 20000; ++i) {
+    const int slot = slot_distribution(prng);
+    if (sizes[slot] == 0) {
+      sizes[slot] = size_distribution(prng);
+      aliasing.Insert(IntToPtr(slot_start(slot)), sizes[slot]);
+      ++num_regions;
+    } else {
+      aliasing.Erase(IntToPtr(slot_start(slot)));
+      sizes[slot] = 0;
+      --num_regions;
+    }
+    ASSERT_EQ(aliasing.size(), num_regions);
+
+    const int start = slot_start(slot_distribution(prng)) +
+                      offset_distribution(prng) - kSlotSize;
+    const int size = size_distribution(prng);
+    bool expected_aliased = false;
+    for (int j = 0; j < kNumSlots; ++j) {
+      if (sizes[j] > 0 && slot_start(j) < start + size &&
+          start < slot_start(j) + sizes[j]) {
+        expected_aliased = true;
+      }
+    }
+    double* aliased_values = nullptr;
+    int aliased_size = 0;
+    ASSERT_EQ(aliasing.FindAliasedRegion(
+                  IntToPtr(start), size, &aliased_values, &aliased_size),
+              expected_aliased);
+    if (expected_aliased) {
+      const int aliased_slot =
+          reinterpret_cast<uintptr_t>(aliased_values) /  // NOLINT
+              (sizeof(double) * kSlotSize) -
+          1;
+      EXPECT_EQ(aliased_size, sizes[aliased_slot]);
+    }
+  }
+}
+
+}  // namespace ceres::internal
@@ -0,0 +1,333 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// Hash maps and sets keyed on pointers, used by ProblemImpl to keep track of
+// the parameter blocks, residual blocks, cost functions and loss functions in
+// a problem.
+//
+// Compared to std::map and std::unordered_map they store their entries in a
+// single contiguous array instead of allocating a node per entry, and use
+// open addressing with linear probing, so that lookups and insertions are
+// O(1) amortized and touch a single cache line in the common case. Deletion
+// uses backward shifting, so there are no tombstones and the performance of
+// the table does not degrade as entries are inserted and removed.
+//
+// The null pointer marks empty slots, and cannot be used as a key. The order
+// of iteration is unspecified, and insertions invalidate all iterators and
+// references into the table.
+
+#ifndef CERES_INTERNAL_POINTER_HASH_MAP_H_
+#define CERES_INTERNAL_POINTER_HASH_MAP_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "ceres/internal/export.h"
+#include "glog/logging.h"
+
+namespace ceres::internal {
+
+namespace pointer_hash_map_internal {
+
+template <typename Key>
+inline Key KeyOf(const Key& slot) {
+  return slot;
+}
+
+template <typename Key, typename Value>
+inline Key KeyOf(const std::pair<Key, Value>& slot) {
+  return slot.first;
+}
+
+}  // namespace pointer_hash_map_internal
+
+// The table shared by PointerHashMap and PointerHashSet. Slot is either Key,
+// or std::pair<Key, Value>.
+template <typename Key, typename Slot>
+class PointerHashTable {
+ public:
+  static_assert(std::is_pointer_v<Key>, "Keys must be pointers.");
+
+  using key_type = Key;
+  using value_type = Slot;
+  using size_type = std::size_t;
+
+  template <typename TableType, typename SlotType>
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = std::remove_const_t<SlotType>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = SlotType*;
+    using reference = SlotType&;
+
+    Iterator() = default;
+    Iterator(TableType* table, size_type index)
+        : table_(table), index_(index) {
+      SkipEmptySlots();
+    }
+    // Conversion from iterator to const_iterator.
+    template <typename OtherTableType, typename OtherSlotType>
+    Iterator(const Iterator<OtherTableType, OtherSlotType>& other)  // NOLINT
+        : table_(other.table_), index_(other.index_) {}
+
+    reference operator*() const { return table_->slots_[index_]; }
+    pointer operator->() const { return &table_->slots_[index_]; }
+    Iterator& operator++() {
+      ++index_;
+      SkipEmptySlots();
+      return *this;
+    }
+    Iterator operator++(int) {
+      Iterator it = *this;
+      ++*this;
+      return it;
+    }
+    bool operator==(const Iterator& other) const {
+      return index_ == other.index_;
+    }
+    bool operator!=(const Iterator& other) const {
+      return index_ != other.index_;
+    }
+
+   private:
+    template <typename, typename>
+    friend class Iterator;
+    friend class PointerHashTable;
+
+    void SkipEmptySlots() {
+      const size_type num_slots = table_->slots_.size();
+      while (index_ < num_slots && table_->IsEmpty(index_)) {
+        ++index_;
+      }
+    }
+
+    TableType* table_ = nullptr;
+    size_type index_ = 0;
+  };
+
+  using iterator = Iterator<PointerHashTable, Slot>;
+  using const_iterator = Iterator<const PointerHashTable, const Slot>;
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  iterator begin() { return iterator(this, 0); }
+  iterator end() { return iterator(this, slots_.size()); }
+  const_iterator begin() const { return const_iterator(this, 0); }
+  const_iterator end() const { return const_iterator(this, slots_.size()); }
+
+  iterator find(Key key) { return iterator(this, FindIndex(key)); }
+  const_iterator find(Key key) const {
+    return const_iterator(this, FindIndex(key));
+  }
+  size_type count(Key key) const {
+    return FindIndex(key) == slots_.size() ? 0 : 1;
+  }
+
+  // Returns the number of entries removed, i.e., 0 or 1.
+  size_type erase(Key key) {
+    const size_type index = FindIndex(key);
+    if (index == slots_.size()) {
+      return 0;
+    }
+    EraseIndex(index);
+    return 1;
+  }
+  void erase(const_iterator it) { EraseIndex(it.index_); }
+
+  void clear() {
+    slots_.clear();
+    size_ = 0;
+  }
+
+  // Grows the table so that it can hold num_entries entries without being
+  // rehashed.
+  void reserve(size_type num_entries) {
+    size_type num_slots = kMinNumSlots;
+    while (MaxSize(num_slots) < num_entries) {
+      num_slots *= 2;
+    }
+    if (num_slots > slots_.size()) {
+      Rehash(num_slots);
+    }
+  }
+
+ protected:
+  // Returns the index of the slot holding key, after inserting slot for it if
+  // needed, and whether the insertion took place.
+  std::pair<size_type, bool> Insert(Key key, Slot&& slot) {
+    CHECK(key != nullptr);
+    if (MaxSize(slots_.size()) <= size_) {
+      Rehash(slots_.empty() ? kMinNumSlots : 2 * slots_.size());
+    }
+    const size_type mask = slots_.size() - 1;
+    for (size_type index = HomeIndex(key);; index = (index + 1) & mask) {
+      if (IsEmpty(index)) {
+        slots_[index] = std::move(slot);
+        ++size_;
+        return {index, true};
+      }
+      if (KeyAt(index) == key) {
+        return {index, false};
+      }
+    }
+  }
+
+  std::vector<Slot> slots_;
+
+ private:
+  static constexpr size_type kMinNumSlots = 16;
+
+  // The table is kept at most 3/4 full.
+  static size_type MaxSize(size_type num_slots) {
+    return num_slots - num_slots / 4;
+  }
+
+  // Fibonacci hashing of the address. Pointers to doubles have their lowest
+  // bits set to zero, and the multiplication moves the well distributed bits
+  // into the most significant half of the product.
+  size_type HomeIndex(Key key) const {
+    constexpr uint64_t kGoldenRatio = 0x9e3779b97f4a7c15ULL;
+    const uint64_t hash =
+        static_cast<uint64_t>(reinterpret_cast<uintptr_t>(key)) * kGoldenRatio;
+    return static_cast<size_type>(hash >> (64 - log2_num_slots_));
+  }
+
+  Key KeyAt(size_type index) const {
+    return pointer_hash_map_internal::KeyOf(slots_[index]);
+  }
+  bool IsEmpty(size_type index) const { return KeyAt(index) == nullptr; }
+
+  size_type FindIndex(Key key) const {
+    if (size_ == 0 || key == nullptr) {
+      return slots_.size();
+    }
+    const size_type mask = slots_.size() - 1;
+    for (size_type index = HomeIndex(key);; index = (index + 1) & mask) {
+      const Key slot_key = KeyAt(index);
+      if (slot_key == key) {
+        return index;
+      }
+      if (slot_key == nullptr) {
+        return slots_.size();
+      }
+    }
+  }
+
+  // Removes the entry at index and shifts the entries following it in its
+  // cluster backwards, so that every entry remains reachable from its home
+  // slot without tombstones.
+  void EraseIndex(size_type index) {
+    const size_type mask = slots_.size() - 1;
+    size_type hole = index;
+    for (size_type next = (hole + 1) & mask; !IsEmpty(next);
+         next = (next + 1) & mask) {
+      const size_type home = HomeIndex(KeyAt(next));
+      // The entry at next can fill the hole if its home slot does not lie
+      // cyclically in (hole, next].
+      if (((next - home) & mask) >= ((next - hole) & mask)) {
+        slots_[hole] = std::move(slots_[next]);
+        hole = next;
+      }
+    }
+    slots_[hole] = Slot();
+    --size_;
+  }
+
+  void Rehash(size_type num_slots) {
+    std::vector<Slot> old_slots(num_slots);
+    old_slots.swap(slots_);
+    log2_num_slots_ = 0;
+    while ((size_type{1} << log2_num_slots_) < num_slots) {
+      ++log2_num_slots_;
+    }
+    const size_type mask = num_slots - 1;
+    for (Slot& slot : old_slots) {
+      const Key key = pointer_hash_map_internal::KeyOf(slot);
+      if (key == nullptr) {
+        continue;
+      }
+      size_type index = HomeIndex(key);
+      while (!IsEmpty(index)) {
+        index = (index + 1) & mask;
+      }
+      slots_[index] = std::move(slot);
+    }
+  }
+
+  size_type size_ = 0;
+  int log2_num_slots_ = 0;
+};
+
+template <typename Key, typename Value>
+class PointerHashMap : public PointerHashTable<Key, std::pair<Key, Value>> {
+  using Base = PointerHashTable<Key, std::pair<Key, Value>>;
+
+ public:
+  using mapped_type = Value;
+  using typename Base::iterator;
+  using typename Base::value_type;
+
+  std::pair<iterator, bool> insert(const value_type& value) {
+    const auto [index, inserted] = Base::Insert(value.first, value_type(value));
+    return {iterator(this, index), inserted};
+  }
+
+  // Returns a reference to the value of key, inserting a value initialized
+  // one if needed.
+  Value& operator[](Key key) {
+    const size_type index = Base::Insert(key, value_type(key, Value())).first;
+    return this->slots_[index].second;
+  }
+
+ private:
+  using typename Base::size_type;
+};
+
+template <typename Key>
+class PointerHashSet : public PointerHashTable<Key, Key> {
+  using Base = PointerHashTable<Key, Key>;
+
+ public:
+  using typename Base::iterator;
+
+  std::pair<iterator, bool> insert(Key key) {
+    const auto [index, inserted] = Base::Insert(key, Key(key));
+    return {iterator(this, index), inserted};
+  }
+};
+
+}  // namespace ceres::internal
+
+#endif  // CERES_INTERNAL_POINTER_HASH_MAP_H_
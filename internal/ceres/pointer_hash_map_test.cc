@@ -0,0 +1,155 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/pointer_hash_map.h"
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "ceres/map_util.h"
+#include "gtest/gtest.h"
+
+namespace ceres::internal {
+
+namespace {
+
+double* IntToPtr(uintptr_t address) {
+  return reinterpret_cast<double*>(address);
+}
+
+}  // namespace
+
+TEST(PointerHashMap, EmptyMap) {
+  PointerHashMap<double*, int> map;
+  EXPECT_TRUE(map.empty());
+  EXPECT_EQ(map.size(), 0);
+  EXPECT_TRUE(map.begin() == map.end());
+  EXPECT_TRUE(map.find(IntToPtr(8)) == map.end());
+  EXPECT_EQ(map.count(IntToPtr(8)), 0);
+  EXPECT_EQ(map.erase(IntToPtr(8)), 0);
+}
+
+TEST(PointerHashMap, InsertFindAndErase) {
+  double x[3];
+  PointerHashMap<double*, int> map;
+  EXPECT_TRUE(map.insert({x, 1}).second);
+  EXPECT_FALSE(map.insert({x, 2}).second);
+  ++map[x + 1];
+  ++map[x + 1];
+  EXPECT_EQ(map.size(), 2);
+  EXPECT_EQ(FindOrDie(map, x), 1);
+  EXPECT_EQ(FindOrDie(map, x + 1), 2);
+  EXPECT_EQ(FindWithDefault(map, x + 2, -1), -1);
+
+  map.erase(map.find(x));
+  EXPECT_EQ(map.size(), 1);
+  EXPECT_EQ(map.count(x), 0);
+  EXPECT_EQ(map.begin()->first, x + 1);
+  EXPECT_EQ(map.erase(x + 1), 1);
+  EXPECT_TRUE(map.empty());
+}
+
+// Compares the map against std::unordered_map under a random sequence of
+// insertions and deletions, with keys which are not aligned and which are
+// clustered in a small range of addresses, as well as keys which are far
+// apart.
+TEST(PointerHashMap, RandomInsertionsAndDeletions) {
+  std::mt19937 prng;
+  std::uniform_int_distribution<uintptr_t> small_address(1, 4096);
+  std::uniform_int_distribution<uintptr_t> large_address(
+      1, std::numeric_limits<uintptr_t>::max());
+  std::uniform_int_distribution<int> operation(0, 2);
+
+  PointerHashMap<double*, int> map;
+  std::unordered_map<double*, int> expected;
+  for (int i = 0; i < 100000; ++i) {
+    double* key = IntToPtr((i % 2) ? small_address(prng) : large_address(prng));
+    if (operation(prng) == 0) {
+      EXPECT_EQ(map.erase(key), expected.erase(key));
+    } else {
+      ++map[key];
+      ++expected[key];
+    }
+    ASSERT_EQ(map.size(), expected.size());
+  }
+
+  int num_entries = 0;
+  for (const auto& [key, value] : map) {
+    EXPECT_EQ(FindOrDie(expected, key), value);
+    ++num_entries;
+  }
+  EXPECT_EQ(num_entries, expected.size());
+  for (const auto& [key, value] : expected) {
+    EXPECT_EQ(FindOrDie(map, key), value);
+  }
+}
+
+TEST(PointerHashMap, Reserve) {
+  std::vector<double> values(1000);
+  PointerHashMap<double*, int> map;
+  map[values.data()] = -1;
+  map.reserve(values.size());
+  for (int i = 0; i < values.size(); ++i) {
+    map[values.data() + i] = i;
+  }
+  EXPECT_EQ(map.size(), values.size());
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(FindOrDie(map, values.data() + i), i);
+  }
+}
+
+TEST(PointerHashSet, InsertFindAndErase) {
+  std::vector<double> values(1000);
+  PointerHashSet<double*> set;
+  std::unordered_set<double*> expected;
+  for (int i = 0; i < values.size(); i += 3) {
+    EXPECT_TRUE(set.insert(values.data() + i).second);
+    EXPECT_FALSE(set.insert(values.data() + i).second);
+    expected.insert(values.data() + i);
+  }
+  for (int i = 0; i < values.size(); i += 2) {
+    EXPECT_EQ(set.erase(values.data() + i), expected.erase(values.data() + i));
+  }
+
+  EXPECT_EQ(set.size(), expected.size());
+  for (double* key : set) {
+    EXPECT_EQ(expected.count(key), 1);
+  }
+  for (int i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(set.count(values.data() + i), expected.count(values.data() + i));
+    EXPECT_EQ(set.find(values.data() + i) != set.end(),
+              ContainsKey(expected, values.data() + i));
+  }
+}
+
+}  // namespace ceres::internal
@@ -63,6 +63,8 @@ class CERES_NO_EXPORT Preconditioner : public LinearOperator {
           row_block_size(linear_solver_options.row_block_size),
           e_block_size(linear_solver_options.e_block_size),
           f_block_size(linear_solver_options.f_block_size),
+          use_lock_free_schur_elimination(
+              linear_solver_options.use_lock_free_schur_elimination),
           context(linear_solver_options.context) {}
 
     PreconditionerType type = JACOBI;
@@ -117,6 +119,9 @@ class CERES_NO_EXPORT Preconditioner : public LinearOperator {
     int e_block_size = Eigen::Dynamic;
     int f_block_size = Eigen::Dynamic;
 
+    // See solver.h for information about this flag.
+    bool use_lock_free_schur_elimination = false;
+
     ContextImpl* context = nullptr;
   };
 
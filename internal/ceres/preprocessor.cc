@@ -30,6 +30,7 @@
 
 #include "ceres/preprocessor.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "ceres/callbacks.h"
@@ -105,4 +106,33 @@ void SetupCommonMinimizerOptions(PreprocessedProblem* pp) {
   }
 }
 
+bool RebindCommon(const Solver::Options& options, PreprocessedProblem* pp) {
+  Solver::Options rebound_options = options;
+  ChangeNumThreadsIfNeeded(&rebound_options);
+  rebound_options.linear_solver_type = pp->options.linear_solver_type;
+  rebound_options.preconditioner_type = pp->options.preconditioner_type;
+  rebound_options.linear_solver_ordering = pp->options.linear_solver_ordering;
+  rebound_options.inner_iteration_ordering =
+      pp->options.inner_iteration_ordering;
+  pp->options = rebound_options;
+
+  const Program& program = pp->problem->program();
+  if (pp->fixed_cost_scratch == nullptr) {
+    pp->fixed_residual_blocks = program.FixedResidualBlocks();
+    pp->fixed_cost_scratch = std::make_unique<double[]>(
+        std::max(1, program.MaxScratchDoublesNeededForEvaluate()));
+  }
+  if (!program.EvaluateFixedCost(pp->fixed_residual_blocks,
+                                 pp->fixed_cost_scratch.get(),
+                                 &pp->fixed_cost,
+                                 &pp->error)) {
+    return false;
+  }
+
+  // Solver::Solve renumbers the parameter blocks according to their
+  // position in the user's program on exit.
+  pp->reduced_program->SetParameterOffsetsAndIndex();
+  return true;
+}
+
 }  // namespace ceres::internal
@@ -31,12 +31,14 @@
 #ifndef CERES_INTERNAL_PREPROCESSOR_H_
 #define CERES_INTERNAL_PREPROCESSOR_H_
 
+#include <map>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "ceres/coordinate_descent_minimizer.h"
 #include "ceres/evaluator.h"
+#include "ceres/execution_summary.h"
 #include "ceres/internal/disable_warnings.h"
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/export.h"
@@ -75,6 +77,16 @@ class CERES_NO_EXPORT Preprocessor {
   virtual bool Preprocess(const Solver::Options& options,
                           ProblemImpl* problem,
                           PreprocessedProblem* pp) = 0;
+
+  // Prepare a PreprocessedProblem computed by an earlier call to
+  // Preprocess for solving the same problem again, after the values
+  // of its parameter blocks have changed but its structure has
+  // not. The reduced program, the linear solver, the evaluator and
+  // the Jacobian are reused, everything which depends on the values
+  // of the parameter blocks or on options which do not affect the
+  // structure of the problem is recomputed.
+  virtual bool Rebind(const Solver::Options& options,
+                      PreprocessedProblem* pp) = 0;
 };
 
 // A PreprocessedProblem is the result of running the Preprocessor on
@@ -101,6 +113,18 @@ struct CERES_NO_EXPORT PreprocessedProblem {
   std::vector<double*> removed_parameter_blocks;
   Vector reduced_parameters;
   double fixed_cost{0.0};
+
+  // The evaluator and the linear solver accumulate their statistics
+  // across calls to Solve when the PreprocessedProblem is reused. These
+  // are their statistics at the start of the current call.
+  std::map<std::string, CallStatistics> initial_evaluator_statistics;
+  std::map<std::string, CallStatistics> initial_linear_solver_statistics;
+
+  // Used by Preprocessor::Rebind to recompute the fixed cost without
+  // scanning the program or allocating memory. Computed by the first
+  // call to Rebind.
+  std::vector<const ResidualBlock*> fixed_residual_blocks;
+  std::unique_ptr<double[]> fixed_cost_scratch;
 };
 
 // Common functions used by various preprocessors.
@@ -117,6 +141,13 @@ void ChangeNumThreadsIfNeeded(Solver::Options* options);
 CERES_NO_EXPORT
 void SetupCommonMinimizerOptions(PreprocessedProblem* pp);
 
+// Update the options, the fixed cost and the parameter block indices
+// of a PreprocessedProblem which is being reused by
+// Preprocessor::Rebind. The options changed by the preprocessor while
+// analyzing the problem (e.g., the orderings) are preserved.
+CERES_NO_EXPORT
+bool RebindCommon(const Solver::Options& options, PreprocessedProblem* pp);
+
 }  // namespace ceres::internal
 
 #include "ceres/internal/reenable_warnings.h"
@@ -65,6 +65,48 @@ ResidualBlockId Problem::AddResidualBlock(CostFunction* cost_function,
       cost_function, loss_function, parameter_blocks, num_parameter_blocks);
 }
 
+void ResidualBlockBatch::AddResidualBlock(
+    CostFunction* cost_function,
+    LossFunction* loss_function,
+    const std::vector<double*>& parameter_blocks) {
+  AddResidualBlock(cost_function,
+                   loss_function,
+                   parameter_blocks.data(),
+                   static_cast<int>(parameter_blocks.size()));
+}
+
+void ResidualBlockBatch::AddResidualBlock(
+    CostFunction* cost_function,
+    LossFunction* loss_function,
+    double* const* const parameter_blocks,
+    int num_parameter_blocks) {
+  residual_blocks_.push_back(
+      {cost_function,
+       loss_function,
+       static_cast<int>(residual_parameter_blocks_.size()),
+       num_parameter_blocks});
+  residual_parameter_blocks_.insert(residual_parameter_blocks_.end(),
+                                    parameter_blocks,
+                                    parameter_blocks + num_parameter_blocks);
+}
+
+void ResidualBlockBatch::AddParameterBlock(double* values, int size) {
+  parameter_blocks_.emplace_back(values, size);
+}
+
+void ResidualBlockBatch::Clear() {
+  residual_blocks_.clear();
+  residual_parameter_blocks_.clear();
+  parameter_blocks_.clear();
+}
+
+void Problem::AddResidualBlocks(
+    const std::vector<ResidualBlockBatch>& batches,
+    int num_threads,
+    std::vector<ResidualBlockId>* residual_block_ids) {
+  impl_->AddResidualBlocks(batches, num_threads, residual_block_ids);
+}
+
 void Problem::AddParameterBlock(double* values, int size) {
   impl_->AddParameterBlock(values, size);
 }
@@ -0,0 +1,283 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// Benchmarks for the construction and modification of problems with the
+// structure and size of the bundle adjustment problems in the BAL dataset,
+// comparing sequential calls to Problem::AddResidualBlock with the batched
+// insertion of residual blocks staged by multiple threads, and the
+// registration of the parameter blocks with a std::map baseline.
+
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "ceres/context_impl.h"
+#include "ceres/parallel_for.h"
+#include "ceres/parameter_block_aliasing.h"
+#include "ceres/pointer_hash_map.h"
+#include "ceres/problem.h"
+#include "ceres/sized_cost_function.h"
+#include "glog/logging.h"
+
+namespace ceres::internal {
+
+namespace {
+
+// A reprojection error with the parameter block sizes used by the BAL
+// problems. It is never evaluated.
+class ReprojectionError final : public SizedCostFunction<2, 9, 3> {
+ public:
+  bool Evaluate(double const* const* parameters,
+                double* residuals,
+                double** jacobians) const override {
+    return false;
+  }
+};
+
+// The parameters and observations of a synthetic bundle adjustment problem,
+// where every point is observed by num_observations_per_point cameras chosen
+// at random.
+struct BundleAdjustmentScene {
+  BundleAdjustmentScene(int num_cameras,
+                        int num_points,
+                        int num_observations_per_point)
+      : cameras(9 * num_cameras), points(3 * num_points) {
+    CHECK_LE(num_observations_per_point, num_cameras);
+    std::mt19937 prng;
+    std::uniform_int_distribution<int> camera_distribution(0,
+                                                           num_cameras - 1);
+    observations.reserve(num_points * num_observations_per_point);
+    for (int i = 0; i < num_points; ++i) {
+      for (int j = 0; j < num_observations_per_point; ++j) {
+        observations.emplace_back(camera_distribution(prng), i);
+      }
+    }
+  }
+
+  // Adds a residual block for each of the observations [start, end) to
+  // target, which is either a Problem or a ResidualBlockBatch.
+  template <typename Target>
+  void AddResidualBlocks(Target* target, int start, int end) {
+    for (int i = start; i < end; ++i) {
+      const auto [camera, point] = observations[i];
+      target->AddResidualBlock(new ReprojectionError,
+                               nullptr,
+                               cameras.data() + 9 * camera,
+                               points.data() + 3 * point);
+    }
+  }
+
+  template <typename Target>
+  void AddResidualBlocks(Target* target) {
+    AddResidualBlocks(target, 0, observations.size());
+  }
+
+  std::vector<double> cameras;
+  std::vector<double> points;
+  std::vector<std::pair<int, int>> observations;
+};
+
+bool RegionsAlias(const double* a, int size_a, const double* b, int size_b) {
+  return (a < b) ? b < (a + size_a) : a < (b + size_b);
+}
+
+// The registration of the parameter blocks by ProblemImpl, with safety checks
+// enabled, using a std::map for both the lookup of the parameter blocks and
+// the detection of aliasing between them, as it did before PointerHashMap and
+// ParameterBlockAliasing were introduced.
+class MapParameterBlockRegistry {
+ public:
+  void AddParameterBlock(double* values, int size) {
+    if (parameter_blocks_.find(values) != parameter_blocks_.end()) {
+      return;
+    }
+    auto lb = parameter_blocks_.lower_bound(values);
+    if (lb != parameter_blocks_.begin()) {
+      auto previous = std::prev(lb);
+      CHECK(!RegionsAlias(previous->first, previous->second, values, size));
+    }
+    if (lb != parameter_blocks_.end()) {
+      CHECK(!RegionsAlias(lb->first, lb->second, values, size));
+    }
+    parameter_blocks_.emplace_hint(lb, values, size);
+  }
+
+ private:
+  std::map<double*, int> parameter_blocks_;
+};
+
+// The registration of the parameter blocks as currently done by ProblemImpl.
+class HashParameterBlockRegistry {
+ public:
+  void AddParameterBlock(double* values, int size) {
+    if (parameter_blocks_.find(values) != parameter_blocks_.end()) {
+      return;
+    }
+    double* aliased_values = nullptr;
+    int aliased_size = 0;
+    CHECK(!aliasing_.FindAliasedRegion(
+        values, size, &aliased_values, &aliased_size));
+    aliasing_.Insert(values, size);
+    parameter_blocks_[values] = size;
+  }
+
+ private:
+  PointerHashMap<double*, int> parameter_blocks_;
+  ParameterBlockAliasing aliasing_;
+};
+
+}  // namespace
+
+// Looks up and registers the parameter blocks of every observation, as
+// AddResidualBlock does, in isolation from the rest of the construction.
+template <typename Registry>
+static void ParameterBlockRegistration(benchmark::State& state) {
+  BundleAdjustmentScene scene(state.range(0), state.range(1), state.range(2));
+  for (auto _ : state) {
+    Registry registry;
+    for (const auto& [camera, point] : scene.observations) {
+      registry.AddParameterBlock(scene.cameras.data() + 9 * camera, 9);
+      registry.AddParameterBlock(scene.points.data() + 3 * point, 3);
+    }
+    benchmark::DoNotOptimize(registry);
+  }
+  state.SetItemsProcessed(state.iterations() * scene.observations.size());
+}
+
+static void ProblemConstruction(benchmark::State& state) {
+  const bool enable_fast_removal = state.range(3);
+  BundleAdjustmentScene scene(state.range(0), state.range(1), state.range(2));
+  for (auto _ : state) {
+    Problem::Options options;
+    options.enable_fast_removal = enable_fast_removal;
+    Problem problem(options);
+    scene.AddResidualBlocks(&problem);
+  }
+  state.SetItemsProcessed(state.iterations() * scene.observations.size());
+}
+
+// Stages the residual blocks in one batch per thread, and adds them to the
+// problem with Problem::AddResidualBlocks.
+static void ProblemBatchedConstruction(benchmark::State& state) {
+  const int num_threads = state.range(3);
+  BundleAdjustmentScene scene(state.range(0), state.range(1), state.range(2));
+  const int num_observations = scene.observations.size();
+  ContextImpl context;
+  context.EnsureMinimumThreads(num_threads);
+  for (auto _ : state) {
+    Problem::Options options;
+    options.context = &context;
+    Problem problem(options);
+    std::vector<ResidualBlockBatch> batches(num_threads);
+    ParallelFor(&context, 0, num_threads, num_threads, [&](int i) {
+      const int64_t start = int64_t{num_observations} * i / num_threads;
+      const int64_t end = int64_t{num_observations} * (i + 1) / num_threads;
+      scene.AddResidualBlocks(&batches[i], start, end);
+    });
+    problem.AddResidualBlocks(batches, num_threads, nullptr);
+  }
+  state.SetItemsProcessed(state.iterations() * num_observations);
+}
+
+// Removes every other point from the problem.
+static void ProblemRemoveParameterBlock(benchmark::State& state) {
+  BundleAdjustmentScene scene(state.range(0), state.range(1), state.range(2));
+  const int num_points = state.range(1);
+  for (auto _ : state) {
+    state.PauseTiming();
+    Problem::Options options;
+    options.enable_fast_removal = true;
+    auto problem = std::make_unique<Problem>(options);
+    scene.AddResidualBlocks(problem.get());
+    state.ResumeTiming();
+    for (int i = 0; i < num_points; i += 2) {
+      problem->RemoveParameterBlock(scene.points.data() + 3 * i);
+    }
+    state.PauseTiming();
+    problem = nullptr;
+    state.ResumeTiming();
+  }
+  state.SetItemsProcessed(state.iterations() * (num_points + 1) / 2);
+}
+
+// The number of cameras and points match those of the Ladybug, Trafalgar,
+// Dubrovnik and Venice problems in the BAL dataset, the number of
+// observations is rounded to the nearest multiple of the number of points.
+BENCHMARK(ProblemConstruction)
+    ->Args({49, 7776, 4, false})
+    ->Args({49, 7776, 4, true})
+    ->Args({257, 65132, 3, false})
+    ->Args({257, 65132, 3, true})
+    ->Args({356, 226730, 6, false})
+    ->Args({356, 226730, 6, true})
+    ->Args({1778, 993923, 5, false})
+    ->Args({1778, 993923, 5, true})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(ParameterBlockRegistration, MapParameterBlockRegistry)
+    ->Args({49, 7776, 4})
+    ->Args({257, 65132, 3})
+    ->Args({356, 226730, 6})
+    ->Args({1778, 993923, 5})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(ParameterBlockRegistration, HashParameterBlockRegistry)
+    ->Args({49, 7776, 4})
+    ->Args({257, 65132, 3})
+    ->Args({356, 226730, 6})
+    ->Args({1778, 993923, 5})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(ProblemBatchedConstruction)
+    ->Args({356, 226730, 6, 1})
+    ->Args({356, 226730, 6, 2})
+    ->Args({356, 226730, 6, 4})
+    ->Args({356, 226730, 6, 8})
+    ->Args({356, 226730, 6, 16})
+    ->Args({1778, 993923, 5, 1})
+    ->Args({1778, 993923, 5, 2})
+    ->Args({1778, 993923, 5, 4})
+    ->Args({1778, 993923, 5, 8})
+    ->Args({1778, 993923, 5, 16})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(ProblemRemoveParameterBlock)
+    ->Args({49, 7776, 4})
+    ->Args({257, 65132, 3})
+    ->Args({356, 226730, 6})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace ceres::internal
+
+BENCHMARK_MAIN();
@@ -32,15 +32,20 @@
 #include "ceres/problem_impl.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <iterator>
 #include <memory>
+#include <new>
 #include <set>
 #include <string>
+#include <tuple>
 #include <utility>
 #include <vector>
 
+#include "ceres/block_arena.h"
 #include "ceres/casts.h"
 #include "ceres/compressed_row_jacobian_writer.h"
 #include "ceres/compressed_row_sparse_matrix.h"
@@ -54,6 +59,7 @@
 #include "ceres/loss_function.h"
 #include "ceres/manifold.h"
 #include "ceres/map_util.h"
+#include "ceres/parallel_for.h"
 #include "ceres/parameter_block.h"
 #include "ceres/program.h"
 #include "ceres/program_evaluator.h"
@@ -86,7 +92,7 @@ void CheckForNoAliasing(double* existing_block,
 
 template <typename KeyType>
 void DecrementValueOrDeleteKey(const KeyType key,
-                               std::map<KeyType, int>* container) {
+                               PointerHashMap<KeyType, int>* container) {
   auto it = container->find(key);
   if (it->second == 1) {
     delete key;
@@ -117,6 +123,13 @@ void InitializeContext(Context* context,
   }
 }
 
+// Structure versions are drawn from a single global sequence, so that a
+// version never identifies the structure of two different problems.
+int64_t NextStructureVersion() {
+  static std::atomic<int64_t> last_structure_version{0};
+  return ++last_structure_version;
+}
+
 }  // namespace
 
 ParameterBlock* ProblemImpl::InternalAddParameterBlock(double* values,
@@ -140,28 +153,20 @@ ParameterBlock* ProblemImpl::InternalAddParameterBlock(double* values,
   if (!options_.disable_all_safety_checks) {
     // Before adding the parameter block, also check that it doesn't alias any
     // other parameter blocks.
-    if (!parameter_block_map_.empty()) {
-      auto lb = parameter_block_map_.lower_bound(values);
-
-      // If lb is not the first block, check the previous block for aliasing.
-      if (lb != parameter_block_map_.begin()) {
-        auto previous = lb;
-        --previous;
-        CheckForNoAliasing(
-            previous->first, previous->second->Size(), values, size);
-      }
-
-      // If lb is not off the end, check lb for aliasing.
-      if (lb != parameter_block_map_.end()) {
-        CheckForNoAliasing(lb->first, lb->second->Size(), values, size);
-      }
+    double* aliased_values = nullptr;
+    int aliased_size = 0;
+    if (parameter_block_aliasing_.FindAliasedRegion(
+            values, size, &aliased_values, &aliased_size)) {
+      CheckForNoAliasing(aliased_values, aliased_size, values, size);
     }
+    parameter_block_aliasing_.Insert(values, size);
   }
 
   // Pass the index of the new parameter block as well to keep the index in
   // sync with the position of the parameter in the program's parameter vector.
-  auto* new_parameter_block =
-      new ParameterBlock(values, size, program_->parameter_blocks_.size());
+  auto* new_parameter_block = new (
+      parameter_block_arena_.Allocate(sizeof(ParameterBlock)))
+      ParameterBlock(values, size, program_->parameter_blocks_.size());
 
   // For dynamic problems, add the list of dependent residual blocks, which is
   // empty to start.
@@ -187,8 +192,7 @@ void ProblemImpl::InternalRemoveResidualBlock(ResidualBlock* residual_block) {
           residual_block);
     }
 
-    auto it = residual_block_set_.find(residual_block);
-    residual_block_set_.erase(it);
+    residual_block_set_.erase(residual_block);
   }
   DeleteBlockInVector(program_->mutable_residual_blocks(), residual_block);
 }
@@ -215,30 +219,48 @@ void ProblemImpl::DeleteBlock(ResidualBlock* residual_block) {
     DecrementValueOrDeleteKey(loss_function, &loss_function_ref_count_);
   }
 
-  delete residual_block;
+  FreeResidualBlock(residual_block);
+}
+
+void ProblemImpl::FreeResidualBlock(ResidualBlock* residual_block) {
+  const int64_t memory_size =
+      ResidualBlock::MemorySize(residual_block->NumParameterBlocks());
+  residual_block->~ResidualBlock();
+  residual_block_arena_.Free(residual_block, memory_size);
 }
 
 // Deletes the parameter block in question, assuming there are no other
 // references to it inside the problem (e.g. by any residual blocks).
 void ProblemImpl::DeleteBlock(ParameterBlock* parameter_block) {
   parameter_block_map_.erase(parameter_block->mutable_user_state());
-  delete parameter_block;
+  if (!options_.disable_all_safety_checks) {
+    parameter_block_aliasing_.Erase(parameter_block->mutable_user_state());
+  }
+  parameter_block->~ParameterBlock();
+  parameter_block_arena_.Free(parameter_block, sizeof(ParameterBlock));
 }
 
 ProblemImpl::ProblemImpl()
-    : options_(Problem::Options()), program_(new internal::Program) {
+    : options_(Problem::Options()),
+      program_(new internal::Program),
+      structure_version_(NextStructureVersion()) {
   InitializeContext(options_.context, &context_impl_, &context_impl_owned_);
 }
 
 ProblemImpl::ProblemImpl(const Problem::Options& options)
-    : options_(options), program_(new internal::Program) {
+    : options_(options),
+      program_(new internal::Program),
+      structure_version_(NextStructureVersion()) {
   program_->evaluation_callback_ = options.evaluation_callback;
   InitializeContext(options_.context, &context_impl_, &context_impl_owned_);
 }
 
 ProblemImpl::~ProblemImpl() {
-  STLDeleteContainerPointers(program_->residual_blocks_.begin(),
-                             program_->residual_blocks_.end());
+  // The arena is released as a whole, so the residual blocks are only
+  // destroyed, not returned to its free lists one by one.
+  for (auto* residual_block : program_->residual_blocks_) {
+    residual_block->~ResidualBlock();
+  }
 
   if (options_.cost_function_ownership == TAKE_OWNERSHIP) {
     STLDeleteContainerPairFirstPointers(cost_function_ref_count_.begin(),
@@ -250,9 +272,10 @@ ProblemImpl::~ProblemImpl() {
                                         loss_function_ref_count_.end());
   }
 
-  // Collect the unique parameterizations and delete the parameters.
+  // The registries and the arena are destroyed as a whole, so the parameter
+  // blocks are only destroyed, not removed from them one by one.
   for (auto* parameter_block : program_->parameter_blocks_) {
-    DeleteBlock(parameter_block);
+    parameter_block->~ParameterBlock();
   }
 
   // Delete the owned manifolds.
@@ -264,11 +287,10 @@ ProblemImpl::~ProblemImpl() {
   }
 }
 
-ResidualBlockId ProblemImpl::AddResidualBlock(
-    CostFunction* cost_function,
-    LossFunction* loss_function,
+void ProblemImpl::CheckResidualBlockArguments(
+    const CostFunction* cost_function,
     double* const* const parameter_blocks,
-    int num_parameter_blocks) {
+    int num_parameter_blocks) const {
   CHECK(cost_function != nullptr);
   CHECK_EQ(num_parameter_blocks, cost_function->parameter_block_sizes().size());
 
@@ -300,63 +322,243 @@ ResidualBlockId ProblemImpl::AddResidualBlock(
                  << "]";
     }
   }
+}
 
-  // Add parameter blocks and convert the double*'s to parameter blocks.
-  std::vector<ParameterBlock*> parameter_block_ptrs(num_parameter_blocks);
-  for (int i = 0; i < num_parameter_blocks; ++i) {
-    parameter_block_ptrs[i] = InternalAddParameterBlock(
-        parameter_blocks[i], parameter_block_sizes[i]);
-  }
-
+void ProblemImpl::CheckParameterBlockSizes(
+    const CostFunction* cost_function,
+    ParameterBlock* const* const parameter_block_ptrs) const {
   if (!options_.disable_all_safety_checks) {
     // Check that the block sizes match the block sizes expected by the
     // cost_function.
-    for (int i = 0; i < parameter_block_ptrs.size(); ++i) {
-      CHECK_EQ(cost_function->parameter_block_sizes()[i],
-               parameter_block_ptrs[i]->Size())
+    const std::vector<int32_t>& parameter_block_sizes =
+        cost_function->parameter_block_sizes();
+    for (int i = 0; i < parameter_block_sizes.size(); ++i) {
+      CHECK_EQ(parameter_block_sizes[i], parameter_block_ptrs[i]->Size())
           << "The cost function expects parameter block " << i << " of size "
-          << cost_function->parameter_block_sizes()[i]
-          << " but was given a block of size "
+          << parameter_block_sizes[i] << " but was given a block of size "
           << parameter_block_ptrs[i]->Size();
     }
   }
+}
 
-  auto* new_residual_block =
-      new ResidualBlock(cost_function,
-                        loss_function,
-                        parameter_block_ptrs,
-                        program_->residual_blocks_.size());
-
+void ProblemImpl::RegisterResidualBlock(ResidualBlock* residual_block) {
   // Add dependencies on the residual to the parameter blocks.
   if (options_.enable_fast_removal) {
-    for (int i = 0; i < num_parameter_blocks; ++i) {
-      parameter_block_ptrs[i]->AddResidualBlock(new_residual_block);
+    for (int i = 0; i < residual_block->NumParameterBlocks(); ++i) {
+      residual_block->parameter_blocks()[i]->AddResidualBlock(residual_block);
     }
-  }
-
-  program_->residual_blocks_.push_back(new_residual_block);
-
-  if (options_.enable_fast_removal) {
-    residual_block_set_.insert(new_residual_block);
+    residual_block_set_.insert(residual_block);
   }
 
   if (options_.cost_function_ownership == TAKE_OWNERSHIP) {
     // Increment the reference count, creating an entry in the table if
-    // needed. Note: C++ maps guarantee that new entries have default
-    // constructed values; this implies integers are zero initialized.
-    ++cost_function_ref_count_[cost_function];
+    // needed. Note: new entries have value initialized values; this implies
+    // integers are zero initialized.
+    ++cost_function_ref_count_[const_cast<CostFunction*>(
+        residual_block->cost_function())];
   }
 
+  auto* loss_function =
+      const_cast<LossFunction*>(residual_block->loss_function());
   if (options_.loss_function_ownership == TAKE_OWNERSHIP &&
       loss_function != nullptr) {
     ++loss_function_ref_count_[loss_function];
   }
+}
+
+ResidualBlockId ProblemImpl::AddResidualBlock(
+    CostFunction* cost_function,
+    LossFunction* loss_function,
+    double* const* const parameter_blocks,
+    int num_parameter_blocks) {
+  CheckResidualBlockArguments(
+      cost_function, parameter_blocks, num_parameter_blocks);
+
+  // Add parameter blocks and convert the double*'s to parameter blocks.
+  const std::vector<int32_t>& parameter_block_sizes =
+      cost_function->parameter_block_sizes();
+  std::vector<ParameterBlock*> parameter_block_ptrs(num_parameter_blocks);
+  for (int i = 0; i < num_parameter_blocks; ++i) {
+    parameter_block_ptrs[i] = InternalAddParameterBlock(
+        parameter_blocks[i], parameter_block_sizes[i]);
+  }
+  CheckParameterBlockSizes(cost_function, parameter_block_ptrs.data());
+
+  auto* new_residual_block = ResidualBlock::Create(
+      residual_block_arena_.Allocate(
+          ResidualBlock::MemorySize(num_parameter_blocks)),
+      cost_function,
+      loss_function,
+      parameter_block_ptrs.data(),
+      program_->residual_blocks_.size());
+  program_->residual_blocks_.push_back(new_residual_block);
+  RegisterResidualBlock(new_residual_block);
 
+  structure_version_ = NextStructureVersion();
   return new_residual_block;
 }
 
+void ProblemImpl::AddResidualBlocks(
+    const std::vector<ResidualBlockBatch>& batches,
+    int num_threads,
+    std::vector<ResidualBlockId>* residual_block_ids) {
+  CHECK_GE(num_threads, 1);
+  const int num_batches = batches.size();
+
+  // The residual blocks of the i-th batch are the residual blocks
+  // [residual_block_offsets[i], residual_block_offsets[i + 1]) of the
+  // concatenation of all batches, and the parameter blocks of its residual
+  // blocks start at parameter_block_offsets[i] in the concatenation of their
+  // parameter blocks.
+  std::vector<int> residual_block_offsets(num_batches + 1, 0);
+  std::vector<int> parameter_block_offsets(num_batches + 1, 0);
+  for (int i = 0; i < num_batches; ++i) {
+    residual_block_offsets[i + 1] =
+        residual_block_offsets[i] + batches[i].residual_blocks_.size();
+    parameter_block_offsets[i + 1] =
+        parameter_block_offsets[i] +
+        batches[i].residual_parameter_blocks_.size();
+  }
+  const int num_new_residual_blocks = residual_block_offsets.back();
+
+  // Calls function(batch, staged_residual_block, index) for the staged
+  // residual blocks with indices in [start, end) in the concatenation of all
+  // batches.
+  auto for_each_residual_block = [&](int start, int end, auto&& function) {
+    int batch_id = std::upper_bound(residual_block_offsets.begin(),
+                                    residual_block_offsets.end(),
+                                    start) -
+                   residual_block_offsets.begin() - 1;
+    for (int i = start; i < end; ++i) {
+      while (i >= residual_block_offsets[batch_id + 1]) {
+        ++batch_id;
+      }
+      const ResidualBlockBatch& batch = batches[batch_id];
+      function(batch_id,
+               batch.residual_blocks_[i - residual_block_offsets[batch_id]],
+               i);
+    }
+  };
+
+  if (num_threads > 1) {
+    context_impl_->EnsureMinimumThreads(num_threads);
+  }
+
+  // Validate the staged residual blocks, and look up the parameter blocks
+  // which are already in the problem. Blocks which are not in the problem yet
+  // are left as nullptr.
+  std::vector<ParameterBlock*> parameter_block_ptrs(
+      parameter_block_offsets.back(), nullptr);
+  ParallelFor(
+      context_impl_,
+      0,
+      num_new_residual_blocks,
+      num_threads,
+      [&](std::tuple<int, int> range) {
+        for_each_residual_block(
+            std::get<0>(range),
+            std::get<1>(range),
+            [&](int batch_id,
+                const ResidualBlockBatch::StagedResidualBlock& staged,
+                int /*index*/) {
+              double* const* parameter_blocks =
+                  batches[batch_id].residual_parameter_blocks_.data() +
+                  staged.begin;
+              CheckResidualBlockArguments(
+                  staged.cost_function, parameter_blocks, staged.size);
+              ParameterBlock** ptrs = parameter_block_ptrs.data() +
+                                      parameter_block_offsets[batch_id] +
+                                      staged.begin;
+              for (int j = 0; j < staged.size; ++j) {
+                ptrs[j] = FindWithDefault(
+                    parameter_block_map_, parameter_blocks[j], nullptr);
+              }
+            });
+      });
+
+  // Add the new parameter blocks, in the same order as the sequential
+  // insertion of the batches would.
+  for (int i = 0; i < num_batches; ++i) {
+    const ResidualBlockBatch& batch = batches[i];
+    for (const auto& [values, size] : batch.parameter_blocks_) {
+      InternalAddParameterBlock(values, size);
+    }
+    ParameterBlock** ptrs =
+        parameter_block_ptrs.data() + parameter_block_offsets[i];
+    for (const auto& staged : batch.residual_blocks_) {
+      for (int j = 0; j < staged.size; ++j) {
+        if (ptrs[staged.begin + j] == nullptr) {
+          ptrs[staged.begin + j] = InternalAddParameterBlock(
+              batch.residual_parameter_blocks_[staged.begin + j],
+              staged.cost_function->parameter_block_sizes()[j]);
+        }
+      }
+    }
+  }
+
+  // Create the residual blocks, next to each other in a single allocation
+  // from the arena.
+  std::vector<int64_t> memory_offsets(num_new_residual_blocks + 1, 0);
+  for_each_residual_block(
+      0,
+      num_new_residual_blocks,
+      [&](int /*batch_id*/,
+          const ResidualBlockBatch::StagedResidualBlock& staged,
+          int index) {
+        memory_offsets[index + 1] =
+            memory_offsets[index] +
+            BlockArena::RoundUp(ResidualBlock::MemorySize(staged.size));
+      });
+  char* memory = nullptr;
+  if (num_new_residual_blocks > 0) {
+    memory = static_cast<char*>(
+        residual_block_arena_.Allocate(memory_offsets.back()));
+  }
+
+  const int num_residual_blocks = program_->residual_blocks_.size();
+  program_->residual_blocks_.resize(num_residual_blocks +
+                                    num_new_residual_blocks);
+  ResidualBlock** new_residual_blocks =
+      program_->residual_blocks_.data() + num_residual_blocks;
+  ParallelFor(
+      context_impl_,
+      0,
+      num_new_residual_blocks,
+      num_threads,
+      [&](std::tuple<int, int> range) {
+        for_each_residual_block(
+            std::get<0>(range),
+            std::get<1>(range),
+            [&](int batch_id,
+                const ResidualBlockBatch::StagedResidualBlock& staged,
+                int index) {
+              ParameterBlock** ptrs = parameter_block_ptrs.data() +
+                                      parameter_block_offsets[batch_id] +
+                                      staged.begin;
+              CheckParameterBlockSizes(staged.cost_function, ptrs);
+              new_residual_blocks[index] =
+                  ResidualBlock::Create(memory + memory_offsets[index],
+                                        staged.cost_function,
+                                        staged.loss_function,
+                                        ptrs,
+                                        num_residual_blocks + index);
+            });
+      });
+
+  for (int i = 0; i < num_new_residual_blocks; ++i) {
+    RegisterResidualBlock(new_residual_blocks[i]);
+  }
+
+  if (residual_block_ids != nullptr) {
+    residual_block_ids->assign(new_residual_blocks,
+                               new_residual_blocks + num_new_residual_blocks);
+  }
+  structure_version_ = NextStructureVersion();
+}
+
 void ProblemImpl::AddParameterBlock(double* values, int size) {
   InternalAddParameterBlock(values, size);
+  structure_version_ = NextStructureVersion();
 }
 
 void ProblemImpl::InternalSetManifold(double* /*values*/,
@@ -373,6 +575,7 @@ void ProblemImpl::AddParameterBlock(double* values,
                                     Manifold* manifold) {
   ParameterBlock* parameter_block = InternalAddParameterBlock(values, size);
   InternalSetManifold(values, parameter_block, manifold);
+  structure_version_ = NextStructureVersion();
 }
 
 // Delete a block from a vector of blocks, maintaining the indexing invariant.
@@ -430,6 +633,7 @@ void ProblemImpl::RemoveResidualBlock(ResidualBlock* residual_block) {
   }
 
   InternalRemoveResidualBlock(residual_block);
+  structure_version_ = NextStructureVersion();
 }
 
 void ProblemImpl::RemoveParameterBlock(const double* values) {
@@ -468,6 +672,7 @@ void ProblemImpl::RemoveParameterBlock(const double* values) {
     }
   }
   DeleteBlockInVector(program_->mutable_parameter_blocks(), parameter_block);
+  structure_version_ = NextStructureVersion();
 }
 
 void ProblemImpl::SetParameterBlockConstant(const double* values) {
@@ -479,7 +684,10 @@ void ProblemImpl::SetParameterBlockConstant(const double* values) {
                << "it can be set constant.";
   }
 
-  parameter_block->SetConstant();
+  if (!parameter_block->IsConstant()) {
+    parameter_block->SetConstant();
+    structure_version_ = NextStructureVersion();
+  }
 }
 
 bool ProblemImpl::IsParameterBlockConstant(const double* values) const {
@@ -500,7 +708,10 @@ void ProblemImpl::SetParameterBlockVariable(double* values) {
                << "it can be set varying.";
   }
 
-  parameter_block->SetVarying();
+  if (parameter_block->IsConstant()) {
+    parameter_block->SetVarying();
+    structure_version_ = NextStructureVersion();
+  }
 }
 
 void ProblemImpl::SetManifold(double* values, Manifold* manifold) {
@@ -513,6 +724,7 @@ void ProblemImpl::SetManifold(double* values, Manifold* manifold) {
   }
 
   InternalSetManifold(values, parameter_block, manifold);
+  structure_version_ = NextStructureVersion();
 }
 
 const Manifold* ProblemImpl::GetManifold(const double* values) const {
@@ -829,10 +1041,13 @@ void ProblemImpl::GetParameterBlocks(
     std::vector<double*>* parameter_blocks) const {
   CHECK(parameter_blocks != nullptr);
   parameter_blocks->resize(0);
-  parameter_blocks->reserve(parameter_block_map_.size());
-  for (const auto& entry : parameter_block_map_) {
-    parameter_blocks->push_back(entry.first);
+  parameter_blocks->reserve(program_->parameter_blocks_.size());
+  for (auto* parameter_block : program_->parameter_blocks_) {
+    parameter_blocks->push_back(parameter_block->mutable_user_state());
   }
+  std::sort(parameter_blocks->begin(),
+            parameter_blocks->end(),
+            std::less<double*>());
 }
 
 void ProblemImpl::GetResidualBlocks(
@@ -40,17 +40,21 @@
 #define CERES_PUBLIC_PROBLEM_IMPL_H_
 
 #include <array>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
+#include "ceres/block_arena.h"
 #include "ceres/context_impl.h"
 #include "ceres/internal/disable_warnings.h"
 #include "ceres/internal/export.h"
 #include "ceres/internal/port.h"
 #include "ceres/manifold.h"
+#include "ceres/parameter_block_aliasing.h"
+#include "ceres/pointer_hash_map.h"
 #include "ceres/problem.h"
 #include "ceres/types.h"
 
@@ -68,10 +72,10 @@ class ResidualBlock;
 
 class CERES_NO_EXPORT ProblemImpl {
  public:
-  using ParameterMap = std::map<double*, ParameterBlock*>;
-  using ResidualBlockSet = std::unordered_set<ResidualBlock*>;
-  using CostFunctionRefCount = std::map<CostFunction*, int>;
-  using LossFunctionRefCount = std::map<LossFunction*, int>;
+  using ParameterMap = PointerHashMap<double*, ParameterBlock*>;
+  using ResidualBlockSet = PointerHashSet<ResidualBlock*>;
+  using CostFunctionRefCount = PointerHashMap<CostFunction*, int>;
+  using LossFunctionRefCount = PointerHashMap<LossFunction*, int>;
 
   ProblemImpl();
   explicit ProblemImpl(const Problem::Options& options);
@@ -98,6 +102,10 @@ class CERES_NO_EXPORT ProblemImpl {
                             static_cast<int>(parameter_blocks.size()));
   }
 
+  void AddResidualBlocks(const std::vector<ResidualBlockBatch>& batches,
+                         int num_threads,
+                         std::vector<ResidualBlockId>* residual_block_ids);
+
   void AddParameterBlock(double* values, int size);
   void AddParameterBlock(double* values, int size, Manifold* manifold);
 
@@ -168,6 +176,11 @@ class CERES_NO_EXPORT ProblemImpl {
 
   const Problem::Options& options() const { return options_; }
 
+  // Changes every time residual or parameter blocks are added or removed,
+  // parameter blocks are made constant or variable, or their manifolds are
+  // changed. Versions are unique across all ProblemImpl objects.
+  int64_t structure_version() const { return structure_version_; }
+
   ContextImpl* context() { return context_impl_; }
 
  private:
@@ -178,6 +191,20 @@ class CERES_NO_EXPORT ProblemImpl {
 
   void InternalRemoveResidualBlock(ResidualBlock* residual_block);
 
+  // The checks AddResidualBlock performs on its arguments before, and on the
+  // parameter blocks after, adding the parameter blocks to the problem.
+  void CheckResidualBlockArguments(const CostFunction* cost_function,
+                                   double* const* const parameter_blocks,
+                                   int num_parameter_blocks) const;
+  void CheckParameterBlockSizes(
+      const CostFunction* cost_function,
+      ParameterBlock* const* const parameter_block_ptrs) const;
+
+  // Adds the residual block to the bookkeeping of the problem, i.e., the
+  // residual block dependencies of its parameter blocks, the residual block set
+  // and the reference counts of its cost and loss functions.
+  void RegisterResidualBlock(ResidualBlock* residual_block);
+
   // Delete the arguments in question. These differ from the Remove* functions
   // in that they do not clean up references to the block to delete; they
   // merely delete them.
@@ -187,6 +214,9 @@ class CERES_NO_EXPORT ProblemImpl {
   void DeleteBlock(ResidualBlock* residual_block);
   void DeleteBlock(ParameterBlock* parameter_block);
 
+  // Destroys the residual block and returns its memory to the arena.
+  void FreeResidualBlock(ResidualBlock* residual_block);
+
   const Problem::Options options_;
 
   bool context_impl_owned_;
@@ -195,12 +225,23 @@ class CERES_NO_EXPORT ProblemImpl {
   // The mapping from user pointers to parameter blocks.
   ParameterMap parameter_block_map_;
 
+  // The memory of the parameter blocks, used to detect aliasing between
+  // them. Empty if Problem::Options::disable_all_safety_checks is true.
+  ParameterBlockAliasing parameter_block_aliasing_;
+
   // Iff enable_fast_removal is enabled, contains the current residual blocks.
   ResidualBlockSet residual_block_set_;
 
   // The actual parameter and residual blocks.
   std::unique_ptr<internal::Program> program_;
 
+  // The memory of the parameter and residual blocks. Each residual block is
+  // allocated together with the pointers to its parameter blocks, in
+  // insertion order. The blocks are not moved when the preprocessor reorders
+  // the program.
+  BlockArena parameter_block_arena_;
+  BlockArena residual_block_arena_;
+
   // TODO(sameeragarwal): Unify the shared object handling across object types.
   // Right now we are using vectors for Manifold objects and reference counting
   // for CostFunctions and LossFunctions. Ideally this should be done uniformly.
@@ -217,6 +258,8 @@ class CERES_NO_EXPORT ProblemImpl {
   // destroyed.
   CostFunctionRefCount cost_function_ref_count_;
   LossFunctionRefCount loss_function_ref_count_;
+
+  int64_t structure_version_;
 };
 
 }  // namespace internal
@@ -46,6 +46,7 @@
 #include "ceres/parameter_block.h"
 #include "ceres/problem_impl.h"
 #include "ceres/program.h"
+#include "ceres/residual_block.h"
 #include "ceres/sized_cost_function.h"
 #include "ceres/sparse_matrix.h"
 #include "ceres/types.h"
@@ -265,6 +266,36 @@ TEST(Problem, AddParameterWithAliasedParametersDies) {
   ASSERT_EQ(5, problem.NumParameterBlocks());
 }
 
+TEST(Problem, AddParameterAfterRemovingAliasedParameter) {
+  Problem problem;
+  problem.AddParameterBlock(IntToPtr(5), 5);
+  problem.AddParameterBlock(IntToPtr(13), 3);
+  problem.RemoveParameterBlock(IntToPtr(5));
+
+  // The memory of the removed block can be reused.
+  problem.AddParameterBlock(IntToPtr(4), 9);
+  EXPECT_DEATH_IF_SUPPORTED(problem.AddParameterBlock(IntToPtr(12), 2),
+                            "Aliasing detected");
+  ASSERT_EQ(2, problem.NumParameterBlocks());
+}
+
+TEST(Problem, GetParameterBlocksReturnsBlocksInAddressOrder) {
+  double values[12];
+  Problem problem;
+  problem.AddParameterBlock(values + 8, 2);
+  problem.AddParameterBlock(values + 2, 3);
+  problem.AddParameterBlock(values + 10, 1);
+  problem.AddParameterBlock(values, 2);
+  problem.RemoveParameterBlock(values + 2);
+  problem.AddParameterBlock(values + 5, 3);
+
+  std::vector<double*> parameter_blocks;
+  problem.GetParameterBlocks(&parameter_blocks);
+  const std::vector<double*> expected_parameter_blocks = {
+      values, values + 5, values + 8, values + 10};
+  EXPECT_EQ(parameter_blocks, expected_parameter_blocks);
+}
+
 TEST(Problem, AddParameterIgnoresDuplicateCalls) {
   double x[3], y[4];
 
@@ -327,6 +358,49 @@ TEST(Problem, ReusedCostFunctionsAreOnlyDeletedOnce) {
   CHECK_EQ(num_destructions, 1);
 }
 
+TEST(Problem, AddResidualBlocksWithDuplicateParametersDies) {
+  double x[3], z[5];
+
+  Problem problem;
+  std::vector<ResidualBlockBatch> batches(2);
+  batches[0].AddResidualBlock(new BinaryCostFunction(2, 5, 3), nullptr, z, x);
+  batches[1].AddResidualBlock(
+      new TernaryCostFunction(1, 5, 3, 5), nullptr, z, x, z);
+  EXPECT_DEATH_IF_SUPPORTED(problem.AddResidualBlocks(batches, 2, nullptr),
+                            "Duplicate parameter blocks");
+}
+
+TEST(Problem, AddResidualBlocksWithIncorrectSizesOfParameterBlockDies) {
+  double x[3], z[5];
+
+  Problem problem;
+  problem.AddParameterBlock(x, 3);
+  std::vector<ResidualBlockBatch> batches(2);
+  batches[0].AddResidualBlock(new UnaryCostFunction(2, 5), nullptr, z);
+  batches[1].AddResidualBlock(new BinaryCostFunction(2, 5, 4), nullptr, z, x);
+  EXPECT_DEATH_IF_SUPPORTED(problem.AddResidualBlocks(batches, 2, nullptr),
+                            "of size 4 but was given a block of size 3");
+}
+
+TEST(Problem, AddResidualBlocksReusedCostFunctionsAreOnlyDeletedOnce) {
+  double y[4], z[5];
+  int num_destructions = 0;
+
+  {
+    Problem problem;
+    CostFunction* cost = new DestructorCountingCostFunction(&num_destructions);
+    problem.AddResidualBlock(cost, nullptr, y, z);
+    std::vector<ResidualBlockBatch> batches(3);
+    for (auto& batch : batches) {
+      batch.AddResidualBlock(cost, nullptr, y, z);
+    }
+    problem.AddResidualBlocks(batches, 3, nullptr);
+    EXPECT_EQ(4, problem.NumResidualBlocks());
+  }
+
+  CHECK_EQ(num_destructions, 1);
+}
+
 TEST(Problem, GetCostFunctionForResidualBlock) {
   double x[3];
   Problem problem;
@@ -1115,6 +1189,96 @@ TEST_P(DynamicProblem, GetXXXBlocksForYYYBlock) {
   // clang-format on
 }
 
+// Adding the residual blocks staged in batches results in the same problem as
+// adding them one by one.
+TEST_P(DynamicProblem, AddResidualBlocksMatchesSequentialInsertion) {
+  constexpr int kNumBatches = 5;
+  constexpr int kNumCameras = 7;
+  constexpr int kNumPoints = 101;
+  std::vector<double> cameras(4 * kNumCameras);
+  std::vector<double> points(3 * kNumPoints);
+
+  // The batches have different sizes, and the last one is empty.
+  std::vector<std::vector<int>> batch_points(kNumBatches);
+  for (int i = 0; i < kNumPoints; ++i) {
+    batch_points[(i * i) % 5 == 1 ? 1 : i % 4].push_back(i);
+  }
+
+  // Every third point is added explicitly, and the points are observed by
+  // every other camera.
+  auto add_blocks = [&](int batch_id, auto* target) {
+    for (const int i : batch_points[batch_id]) {
+      if (i % 3 == 0) {
+        target->AddParameterBlock(points.data() + 3 * i, 3);
+      }
+    }
+    for (const int i : batch_points[batch_id]) {
+      for (int j = i % 2; j < kNumCameras; j += 2) {
+        target->AddResidualBlock(new BinaryCostFunction(2, 4, 3),
+                                 nullptr,
+                                 cameras.data() + 4 * j,
+                                 points.data() + 3 * i);
+      }
+    }
+  };
+
+  // Some of the parameter blocks are already in the problem.
+  Problem::Options options;
+  options.enable_fast_removal = GetParam();
+  ProblemImpl expected(options);
+  for (ProblemImpl* target : {problem.get(), &expected}) {
+    target->AddParameterBlock(cameras.data() + 4, 4);
+    target->AddResidualBlock(
+        new UnaryCostFunction(1, 3), nullptr, points.data() + 9);
+  }
+
+  std::vector<ResidualBlockBatch> batches(kNumBatches);
+  for (int i = 0; i < kNumBatches; ++i) {
+    add_blocks(i, &batches[i]);
+    add_blocks(i, &expected);
+  }
+  EXPECT_EQ(batches.back().NumResidualBlocks(), 0);
+
+  std::vector<ResidualBlockId> residual_block_ids;
+  problem->AddResidualBlocks(batches, 4, &residual_block_ids);
+
+  const Program& program = problem->program();
+  const Program& expected_program = expected.program();
+  ASSERT_EQ(program.NumParameterBlocks(),
+            expected_program.NumParameterBlocks());
+  for (int i = 0; i < program.NumParameterBlocks(); ++i) {
+    ParameterBlock* parameter_block = program.parameter_blocks()[i];
+    ParameterBlock* expected_parameter_block =
+        expected_program.parameter_blocks()[i];
+    EXPECT_EQ(parameter_block->user_state(),
+              expected_parameter_block->user_state());
+    EXPECT_EQ(parameter_block->Size(), expected_parameter_block->Size());
+    if (GetParam()) {
+      EXPECT_EQ(
+          parameter_block->mutable_residual_blocks()->size(),
+          expected_parameter_block->mutable_residual_blocks()->size());
+    }
+  }
+
+  ASSERT_EQ(NumResidualBlocks(), expected.NumResidualBlocks());
+  ASSERT_EQ(residual_block_ids.size(), NumResidualBlocks() - 1);
+  for (int i = 0; i < NumResidualBlocks(); ++i) {
+    const ResidualBlock* residual_block = program.residual_blocks()[i];
+    const ResidualBlock* expected_residual_block =
+        expected_program.residual_blocks()[i];
+    EXPECT_EQ(residual_block->index(), i);
+    if (i > 0) {
+      EXPECT_EQ(residual_block, residual_block_ids[i - 1]);
+    }
+    ASSERT_EQ(residual_block->NumParameterBlocks(),
+              expected_residual_block->NumParameterBlocks());
+    for (int j = 0; j < residual_block->NumParameterBlocks(); ++j) {
+      EXPECT_EQ(residual_block->parameter_blocks()[j]->user_state(),
+                expected_residual_block->parameter_blocks()[j]->user_state());
+    }
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(OptionsInstantiation,
                          DynamicProblem,
                          ::testing::Values(true, false));
@@ -302,6 +302,64 @@ std::unique_ptr<Program> Program::CreateReducedProgram(
   return reduced_program;
 }
 
+std::vector<const ResidualBlock*> Program::FixedResidualBlocks() const {
+  std::vector<const ResidualBlock*> fixed_residual_blocks;
+  for (const ResidualBlock* residual_block : residual_blocks_) {
+    const int num_parameter_blocks = residual_block->NumParameterBlocks();
+    bool all_constant = true;
+    for (int k = 0; k < num_parameter_blocks; k++) {
+      if (!residual_block->parameter_blocks()[k]->IsConstant()) {
+        all_constant = false;
+        break;
+      }
+    }
+
+    if (all_constant) {
+      fixed_residual_blocks.push_back(residual_block);
+    }
+  }
+  return fixed_residual_blocks;
+}
+
+bool Program::EvaluateFixedCost(
+    const std::vector<const ResidualBlock*>& fixed_residual_blocks,
+    double* scratch,
+    double* fixed_cost,
+    std::string* error) const {
+  CHECK(fixed_cost != nullptr);
+  CHECK(error != nullptr);
+
+  *fixed_cost = 0.0;
+  if (fixed_residual_blocks.empty()) {
+    return true;
+  }
+  CHECK(scratch != nullptr);
+
+  // See RemoveFixedBlocks for why the EvaluationCallback is only
+  // called if there is a constant residual block.
+  if (evaluation_callback_ != nullptr) {
+    constexpr bool kNewPoint = true;
+    constexpr bool kDoNotEvaluateJacobians = false;
+    evaluation_callback_->PrepareForEvaluation(kDoNotEvaluateJacobians,
+                                               kNewPoint);
+  }
+
+  for (int i = 0; i < fixed_residual_blocks.size(); ++i) {
+    double cost = 0.0;
+    if (!fixed_residual_blocks[i]->Evaluate(
+            true, &cost, nullptr, nullptr, scratch)) {
+      *error = StringPrintf(
+          "Evaluation of the fixed residual %d failed during "
+          "evaluation of the fixed cost.",
+          i);
+      return false;
+    }
+
+    *fixed_cost += cost;
+  }
+  return true;
+}
+
 bool Program::RemoveFixedBlocks(std::vector<double*>* removed_parameter_blocks,
                                 double* fixed_cost,
                                 std::string* error) {
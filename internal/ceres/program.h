@@ -154,6 +154,24 @@ class CERES_NO_EXPORT Program {
       double* fixed_cost,
       std::string* error) const;
 
+  // The residual blocks with no varying parameter blocks, i.e., the
+  // ones removed by CreateReducedProgram.
+  std::vector<const ResidualBlock*> FixedResidualBlocks() const;
+
+  // Compute the sum of the costs of fixed_residual_blocks, as returned
+  // by FixedResidualBlocks, at the current values of the parameter
+  // blocks. This is the fixed_cost computed by CreateReducedProgram.
+  // scratch must have room for MaxScratchDoublesNeededForEvaluate()
+  // doubles.
+  //
+  // If there was a problem, then the function will return false and
+  // error will contain a human readable description of the problem.
+  bool EvaluateFixedCost(
+      const std::vector<const ResidualBlock*>& fixed_residual_blocks,
+      double* scratch,
+      double* fixed_cost,
+      std::string* error) const;
+
   // See problem.h for what these do.
   int NumParameterBlocks() const;
   int NumParameters() const;
@@ -45,6 +45,12 @@
 //
 // The evaluation is threaded with C++ threads.
 //
+// Residual blocks whose cost functions are BatchCostFunctions are grouped into
+// batches (see residual_block_batch.h), and the cost function of each batch is
+// evaluated with a single call when the loop over the residual blocks reaches
+// the first residual block of the batch. All other residual blocks are
+// evaluated one at a time.
+//
 // The EvaluatePreparer and JacobianWriter interfaces are as follows:
 //
 //   class EvaluatePreparer {
@@ -100,6 +106,7 @@
 #include "ceres/parameter_block.h"
 #include "ceres/program.h"
 #include "ceres/residual_block.h"
+#include "ceres/residual_block_batch.h"
 #include "ceres/small_blas.h"
 
 namespace ceres {
@@ -124,6 +131,14 @@ class ProgramEvaluator final : public Evaluator {
     BuildResidualLayout(*program, &residual_layout_);
     evaluate_scratch_ = std::move(CreateEvaluatorScratch(
         *program, static_cast<unsigned>(options.num_threads)));
+    residual_block_batches_ = ComputeResidualBlockBatches(*program);
+    if (residual_block_batches_.num_batches() > 0) {
+      batch_evaluators_ = std::make_unique<ResidualBlockBatchEvaluator[]>(
+          options.num_threads);
+      for (int i = 0; i < options.num_threads; ++i) {
+        batch_evaluators_[i].Init(residual_block_batches_);
+      }
+    }
   }
 
   // Implementation of Evaluator interface.
@@ -179,6 +194,8 @@ class ProgramEvaluator final : public Evaluator {
     }
 
     const int num_residual_blocks = program_->NumResidualBlocks();
+    const std::vector<int>& batches = residual_block_batches_.first_in_batch;
+    const int* first_in_batch = batches.empty() ? nullptr : batches.data();
     // This bool is used to disable the loop if an error is encountered without
     // breaking out of it. The remaining loop iterations are still run, but with
     // an empty body, and so will finish quickly.
@@ -193,66 +210,42 @@ class ProgramEvaluator final : public Evaluator {
             return;
           }
 
-          EvaluatePreparer* preparer = &evaluate_preparers_[thread_id];
-          EvaluateScratch* scratch = &evaluate_scratch_[thread_id];
-
-          // Prepare block residuals if requested.
-          const ResidualBlock* residual_block = program_->residual_blocks()[i];
-          double* block_residuals = nullptr;
-          if (residuals != nullptr) {
-            block_residuals = residuals + residual_layout_[i];
-          } else if (gradient != nullptr) {
-            block_residuals = scratch->residual_block_residuals.get();
-          }
-
-          // Prepare block jacobians if requested.
-          double** block_jacobians = nullptr;
-          if (jacobian != nullptr || gradient != nullptr) {
-            preparer->Prepare(residual_block,
-                              i,
-                              jacobian,
-                              scratch->jacobian_block_ptrs.get());
-            block_jacobians = scratch->jacobian_block_ptrs.get();
-          }
-
-          // Evaluate the cost, residuals, and jacobians.
-          double block_cost;
-          if (!residual_block->Evaluate(
-                  evaluate_options.apply_loss_function,
-                  &block_cost,
-                  block_residuals,
-                  block_jacobians,
-                  scratch->residual_block_evaluate_scratch.get())) {
-            abort = true;
+          // Residual blocks with a BatchCostFunction are evaluated together
+          // with the rest of their batch when its first residual block is
+          // reached.
+          if (first_in_batch != nullptr &&
+              first_in_batch[i] != ResidualBlockBatches::kNotBatched) {
+            if (first_in_batch[i] != ResidualBlockBatches::kInBatch &&
+                !EvaluateResidualBlockBatch(thread_id,
+                                            first_in_batch[i],
+                                            evaluate_options,
+                                            residuals,
+                                            gradient,
+                                            jacobian)) {
+              abort = true;
+            }
             return;
           }
 
-          scratch->cost += block_cost;
-
-          // Store the jacobians, if they were requested.
-          if (jacobian != nullptr) {
-            jacobian_writer_.Write(
-                i, residual_layout_[i], block_jacobians, jacobian);
-          }
-
-          // Compute and store the gradient, if it was requested.
-          if (gradient != nullptr) {
-            int num_residuals = residual_block->NumResiduals();
-            int num_parameter_blocks = residual_block->NumParameterBlocks();
-            for (int j = 0; j < num_parameter_blocks; ++j) {
-              const ParameterBlock* parameter_block =
-                  residual_block->parameter_blocks()[j];
-              if (parameter_block->IsConstant()) {
-                continue;
-              }
-
-              MatrixTransposeVectorMultiply<Eigen::Dynamic, Eigen::Dynamic, 1>(
-                  block_jacobians[j],
-                  num_residuals,
-                  parameter_block->TangentSize(),
-                  block_residuals,
-                  scratch->gradient.get() + parameter_block->delta_offset());
-            }
+          if (!EvaluateResidualBlock(
+                  thread_id,
+                  i,
+                  residuals,
+                  gradient,
+                  jacobian,
+                  [&](const ResidualBlock* residual_block,
+                      double* block_cost,
+                      double* block_residuals,
+                      double** block_jacobians,
+                      double* scratch) {
+                    return residual_block->Evaluate(
+                        evaluate_options.apply_loss_function,
+                        block_cost,
+                        block_residuals,
+                        block_jacobians,
+                        scratch);
+                  })) {
+            abort = true;
           }
         });
 
@@ -319,6 +312,129 @@ class ProgramEvaluator final : public Evaluator {
   }
 
  private:
+  // Evaluates the i'th residual block of the program, and writes its jacobian
+  // and gradient. The cost function of the residual block is evaluated by
+  // calling evaluate, which has the signature of ResidualBlock::Evaluate
+  // without apply_loss_function.
+  template <typename EvaluateFunction>
+  bool EvaluateResidualBlock(int thread_id,
+                             int i,
+                             double* residuals,
+                             double* gradient,
+                             SparseMatrix* jacobian,
+                             const EvaluateFunction& evaluate) {
+    EvaluatePreparer* preparer = &evaluate_preparers_[thread_id];
+    EvaluateScratch* scratch = &evaluate_scratch_[thread_id];
+
+    // Prepare block residuals if requested.
+    const ResidualBlock* residual_block = program_->residual_blocks()[i];
+    double* block_residuals = nullptr;
+    if (residuals != nullptr) {
+      block_residuals = residuals + residual_layout_[i];
+    } else if (gradient != nullptr) {
+      block_residuals = scratch->residual_block_residuals.get();
+    }
+
+    // Prepare block jacobians if requested.
+    double** block_jacobians = nullptr;
+    if (jacobian != nullptr || gradient != nullptr) {
+      preparer->Prepare(
+          residual_block, i, jacobian, scratch->jacobian_block_ptrs.get());
+      block_jacobians = scratch->jacobian_block_ptrs.get();
+    }
+
+    // Evaluate the cost, residuals, and jacobians.
+    double block_cost;
+    if (!evaluate(residual_block,
+                  &block_cost,
+                  block_residuals,
+                  block_jacobians,
+                  scratch->residual_block_evaluate_scratch.get())) {
+      return false;
+    }
+
+    scratch->cost += block_cost;
+
+    // Store the jacobians, if they were requested.
+    if (jacobian != nullptr) {
+      jacobian_writer_.Write(i, residual_layout_[i], block_jacobians, jacobian);
+    }
+
+    // Compute and store the gradient, if it was requested.
+    if (gradient != nullptr) {
+      int num_residuals = residual_block->NumResiduals();
+      int num_parameter_blocks = residual_block->NumParameterBlocks();
+      for (int j = 0; j < num_parameter_blocks; ++j) {
+        const ParameterBlock* parameter_block =
+            residual_block->parameter_blocks()[j];
+        if (parameter_block->IsConstant()) {
+          continue;
+        }
+
+        MatrixTransposeVectorMultiply<Eigen::Dynamic, Eigen::Dynamic, 1>(
+            block_jacobians[j],
+            num_residuals,
+            parameter_block->TangentSize(),
+            block_residuals,
+            scratch->gradient.get() + parameter_block->delta_offset());
+      }
+    }
+    return true;
+  }
+
+  // Evaluates the residual blocks of a batch with one call to their batch
+  // cost function. The residual blocks are then finished one at a time, since
+  // the evaluate preparers only hold the jacobians of one residual block at a
+  // time. With the BlockEvaluatePreparer, the jacobians are copied straight
+  // from the batch into the jacobian matrix.
+  bool EvaluateResidualBlockBatch(
+      int thread_id,
+      int batch,
+      const Evaluator::EvaluateOptions& evaluate_options,
+      double* residuals,
+      double* gradient,
+      SparseMatrix* jacobian) {
+    ResidualBlockBatchEvaluator* batch_evaluator =
+        &batch_evaluators_[thread_id];
+    const bool compute_jacobians = (jacobian != nullptr || gradient != nullptr);
+    if (!batch_evaluator->Evaluate(residual_block_batches_,
+                                   batch,
+                                   program_->residual_blocks(),
+                                   compute_jacobians)) {
+      return false;
+    }
+
+    const int start = residual_block_batches_.offsets[batch];
+    const int batch_size = residual_block_batches_.batch_size(batch);
+    for (int k = 0; k < batch_size; ++k) {
+      if (!EvaluateResidualBlock(
+              thread_id,
+              residual_block_batches_.residual_blocks[start + k],
+              residuals,
+              gradient,
+              jacobian,
+              [&](const ResidualBlock* residual_block,
+                  double* block_cost,
+                  double* block_residuals,
+                  double** block_jacobians,
+                  double* scratch) {
+                return residual_block->EvaluateFromBatch(
+                    k,
+                    batch_size,
+                    batch_evaluator->residuals(),
+                    batch_evaluator->jacobians(),
+                    evaluate_options.apply_loss_function,
+                    block_cost,
+                    block_residuals,
+                    block_jacobians,
+                    scratch);
+              })) {
+        return false;
+      }
+    }
+    return true;
+  }
+
   // Per-thread scratch space needed to evaluate and store each residual block.
   struct EvaluateScratch {
     void Init(int max_parameters_per_residual_block,
@@ -327,8 +443,10 @@ class ProgramEvaluator final : public Evaluator {
               int num_parameters) {
       residual_block_evaluate_scratch =
           std::make_unique<double[]>(max_scratch_doubles_needed_for_evaluate);
-      gradient = std::make_unique<double[]>(num_parameters);
-      VectorRef(gradient.get(), num_parameters).setZero();
+      // The gradient is left uninitialized; it is zeroed by ParallelSetZero
+      // before use, so that its pages are first touched (and hence placed on
+      // NUMA nodes) by the threads using them.
+      gradient = std::unique_ptr<double[]>(new double[num_parameters]);
       residual_block_residuals =
           std::make_unique<double[]>(max_residuals_per_residual_block);
       jacobian_block_ptrs =
@@ -384,6 +502,8 @@ class ProgramEvaluator final : public Evaluator {
   std::unique_ptr<EvaluatePreparer[]> evaluate_preparers_;
   std::unique_ptr<EvaluateScratch[]> evaluate_scratch_;
   std::vector<int> residual_layout_;
+  ResidualBlockBatches residual_block_batches_;
+  std::unique_ptr<ResidualBlockBatchEvaluator[]> batch_evaluators_;
   int num_parameters_;
   ::ceres::internal::ExecutionSummary execution_summary_;
 };
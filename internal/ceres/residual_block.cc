@@ -33,6 +33,8 @@
 
 #include <algorithm>
 #include <cstddef>
+#include <cstdint>
+#include <new>
 #include <vector>
 
 #include "ceres/corrector.h"
@@ -49,20 +51,49 @@ using Eigen::Dynamic;
 
 namespace ceres::internal {
 
-ResidualBlock::ResidualBlock(
-    const CostFunction* cost_function,
-    const LossFunction* loss_function,
-    const std::vector<ParameterBlock*>& parameter_blocks,
-    int index)
+ResidualBlock::ResidualBlock(const CostFunction* cost_function,
+                             const LossFunction* loss_function,
+                             ParameterBlock* const* parameter_blocks,
+                             ParameterBlock** parameter_block_storage,
+                             int index)
     : cost_function_(cost_function),
       loss_function_(loss_function),
-      parameter_blocks_(
-          new ParameterBlock*[cost_function->parameter_block_sizes().size()]),
+      parameter_blocks_(parameter_block_storage),
       index_(index) {
   CHECK(cost_function_ != nullptr);
-  std::copy(parameter_blocks.begin(),
-            parameter_blocks.end(),
-            parameter_blocks_.get());
+  std::copy_n(parameter_blocks,
+              cost_function_->parameter_block_sizes().size(),
+              parameter_blocks_);
+}
+
+namespace {
+
+// The offset of the parameter block pointers from the start of the memory of
+// a residual block constructed by ResidualBlock::Create.
+constexpr int64_t kParameterBlocksOffset =
+    (sizeof(ResidualBlock) + alignof(ParameterBlock*) - 1) /
+    alignof(ParameterBlock*) * alignof(ParameterBlock*);
+
+}  // namespace
+
+ResidualBlock* ResidualBlock::Create(void* memory,
+                                     const CostFunction* cost_function,
+                                     const LossFunction* loss_function,
+                                     ParameterBlock* const* parameter_blocks,
+                                     int index) {
+  CHECK(memory != nullptr);
+  auto* parameter_block_storage = reinterpret_cast<ParameterBlock**>(
+      static_cast<char*>(memory) + kParameterBlocksOffset);
+  return new (memory) ResidualBlock(cost_function,
+                                    loss_function,
+                                    parameter_blocks,
+                                    parameter_block_storage,
+                                    index);
+}
+
+int64_t ResidualBlock::MemorySize(int num_parameter_blocks) {
+  return kParameterBlocksOffset +
+         int64_t{num_parameter_blocks} * sizeof(ParameterBlock*);
 }
 
 bool ResidualBlock::Evaluate(const bool apply_loss_function,
@@ -195,6 +226,95 @@ bool ResidualBlock::Evaluate(const bool apply_loss_function,
   return true;
 }
 
+bool ResidualBlock::EvaluateFromBatch(const int batch_index,
+                                      const int batch_size,
+                                      const double* batch_residuals,
+                                      double const* const* batch_jacobians,
+                                      const bool apply_loss_function,
+                                      double* cost,
+                                      double* residuals,
+                                      double** jacobians,
+                                      double* scratch) const {
+  const int num_parameter_blocks = NumParameterBlocks();
+  const int num_residuals = cost_function_->num_residuals();
+
+  const bool outputting_residuals = (residuals != nullptr);
+  if (!outputting_residuals) {
+    residuals = scratch;
+    scratch += num_residuals;
+  }
+
+  for (int r = 0; r < num_residuals; ++r) {
+    residuals[r] = batch_residuals[r * batch_size + batch_index];
+  }
+
+  if (jacobians != nullptr) {
+    for (int i = 0; i < num_parameter_blocks; ++i) {
+      if (jacobians[i] == nullptr) {
+        continue;
+      }
+      const ParameterBlock* parameter_block = parameter_blocks_[i];
+      const int size = parameter_block->Size();
+      const int num_values = num_residuals * size;
+      const double* batch_jacobian = batch_jacobians[i] + batch_index;
+
+      if (parameter_block->PlusJacobian() == nullptr) {
+        for (int j = 0; j < num_values; ++j) {
+          jacobians[i][j] = batch_jacobian[j * batch_size];
+        }
+        continue;
+      }
+
+      // jacobians[i] = global_jacobian * global_to_local_jacobian.
+      for (int j = 0; j < num_values; ++j) {
+        scratch[j] = batch_jacobian[j * batch_size];
+      }
+      MatrixMatrixMultiply<Dynamic, Dynamic, Dynamic, Dynamic, 0>(
+          scratch,
+          num_residuals,
+          size,
+          parameter_block->PlusJacobian(),
+          size,
+          parameter_block->TangentSize(),
+          jacobians[i],
+          0,
+          0,
+          num_residuals,
+          parameter_block->TangentSize());
+    }
+  }
+
+  const double squared_norm =
+      VectorRef(residuals, num_residuals).squaredNorm();
+  if (loss_function_ == nullptr || !apply_loss_function) {
+    *cost = 0.5 * squared_norm;
+    return true;
+  }
+
+  double rho[3];
+  loss_function_->Evaluate(squared_norm, rho);
+  *cost = 0.5 * rho[0];
+  if (jacobians == nullptr && !outputting_residuals) {
+    return true;
+  }
+
+  Corrector correct(squared_norm, rho);
+  if (jacobians != nullptr) {
+    for (int i = 0; i < num_parameter_blocks; ++i) {
+      if (jacobians[i] != nullptr) {
+        correct.CorrectJacobian(num_residuals,
+                                parameter_blocks_[i]->TangentSize(),
+                                residuals,
+                                jacobians[i]);
+      }
+    }
+  }
+  if (outputting_residuals) {
+    correct.CorrectResiduals(num_residuals, residuals);
+  }
+  return true;
+}
+
 int ResidualBlock::NumScratchDoublesForEvaluate() const {
   // Compute the amount of scratch space needed to store the full-sized
   // jacobians. For parameters that have no manifold no storage is needed and
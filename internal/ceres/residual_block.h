@@ -68,13 +68,21 @@ class ParameterBlock;
 // loss functions, and parameter blocks.
 class CERES_NO_EXPORT ResidualBlock {
  public:
-  // Construct the residual block with the given cost/loss functions. Loss may
-  // be null. The index is the index of the residual block in the Program's
-  // residual_blocks array.
-  ResidualBlock(const CostFunction* cost_function,
-                const LossFunction* loss_function,
-                const std::vector<ParameterBlock*>& parameter_blocks,
-                int index);
+  // Construct the residual block with the given cost/loss functions in
+  // memory, which must be aligned to alignof(std::max_align_t) and at least
+  // MemorySize(num_parameter_blocks) bytes large. Loss may be null. The index
+  // is the index of the residual block in the Program's residual_blocks array.
+  //
+  // The pointers to the parameter blocks are stored in the same memory, right
+  // after the residual block, instead of in a separate heap allocation. The
+  // residual block must be destroyed by calling its destructor, after which
+  // the memory can be released.
+  static ResidualBlock* Create(void* memory,
+                               const CostFunction* cost_function,
+                               const LossFunction* loss_function,
+                               ParameterBlock* const* parameter_blocks,
+                               int index);
+  static int64_t MemorySize(int num_parameter_blocks);
 
   // Evaluates the residual term, storing the scalar cost in *cost, the residual
   // components in *residuals, and the jacobians between the parameters and
@@ -106,13 +114,33 @@ class CERES_NO_EXPORT ResidualBlock {
                 double** jacobians,
                 double* scratch) const;
 
+  // Same as Evaluate, except that the cost function is not called. Instead,
+  // its output is read from a batch of residual blocks evaluated with
+  // BatchCostFunction::EvaluateBatch, in which this residual block has index
+  // batch_index. batch_residuals and batch_jacobians are in the structure of
+  // arrays layout of EvaluateBatch, and batch_jacobians[i] must not be null if
+  // jacobians[i] is not. The batch must already have been checked to be valid,
+  // see ResidualBlockBatchEvaluator.
+  //
+  // The residuals and the jacobians are copied straight out of the batch into
+  // their destination, with the manifold and loss function applied on the way.
+  bool EvaluateFromBatch(int batch_index,
+                         int batch_size,
+                         const double* batch_residuals,
+                         double const* const* batch_jacobians,
+                         bool apply_loss_function,
+                         double* cost,
+                         double* residuals,
+                         double** jacobians,
+                         double* scratch) const;
+
   const CostFunction* cost_function() const { return cost_function_; }
   const LossFunction* loss_function() const { return loss_function_; }
 
   // Access the parameter blocks for this residual. The array has size
   // NumParameterBlocks().
   ParameterBlock* const* parameter_blocks() const {
-    return parameter_blocks_.get();
+    return parameter_blocks_;
   }
 
   // Number of variable blocks that this residual term depends on.
@@ -135,9 +163,16 @@ class CERES_NO_EXPORT ResidualBlock {
   }
 
  private:
+  ResidualBlock(const CostFunction* cost_function,
+                const LossFunction* loss_function,
+                ParameterBlock* const* parameter_blocks,
+                ParameterBlock** parameter_block_storage,
+                int index);
+
   const CostFunction* cost_function_;
   const LossFunction* loss_function_;
-  std::unique_ptr<ParameterBlock*[]> parameter_blocks_;
+  // Points into the memory the residual block was created in.
+  ParameterBlock** parameter_blocks_;
 
   // The index of the residual, typically in a Program. This is only to permit
   // switching from a ResidualBlock* to an index in the Program's array, needed
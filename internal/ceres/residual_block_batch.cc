@@ -0,0 +1,252 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/residual_block_batch.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <numeric>
+#include <tuple>
+#include <typeindex>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "ceres/array_utils.h"
+#include "ceres/parameter_block.h"
+#include "ceres/program.h"
+#include "ceres/residual_block.h"
+#include "glog/logging.h"
+
+namespace ceres::internal {
+
+namespace {
+
+// Residual blocks can share a batch only if they have the same key: the type,
+// maximum batch size and shape of their cost functions, and which of their
+// parameter blocks are constant. Since the constant parameter blocks are the
+// same in a batch, the jacobians of a batch are computed only for parameter
+// blocks that are varying in every one of its residual blocks.
+using BatchKey = std::tuple<std::type_index,
+                            int,
+                            int,
+                            std::vector<int32_t>,
+                            std::vector<bool>>;
+
+BatchKey KeyOf(const ResidualBlock& residual_block,
+               const BatchCostFunction& cost_function) {
+  const int num_parameter_blocks = residual_block.NumParameterBlocks();
+  std::vector<bool> is_constant(num_parameter_blocks);
+  for (int i = 0; i < num_parameter_blocks; ++i) {
+    is_constant[i] = residual_block.parameter_blocks()[i]->IsConstant();
+  }
+  return BatchKey(std::type_index(typeid(cost_function)),
+                  cost_function.max_batch_size(),
+                  cost_function.num_residuals(),
+                  cost_function.parameter_block_sizes(),
+                  std::move(is_constant));
+}
+
+}  // namespace
+
+ResidualBlockBatches ComputeResidualBlockBatches(const Program& program) {
+  const std::vector<ResidualBlock*>& residual_blocks =
+      program.residual_blocks();
+  const int num_residual_blocks = residual_blocks.size();
+  ResidualBlockBatches batches;
+
+  // Visit the residual blocks in program order, adding each one to the open
+  // batch of its key until that batch is full. Batches are numbered in the
+  // order of their first residual block.
+  //
+  // This is the only place where the type of the cost functions is inspected,
+  // so that the evaluation itself does not need any casts.
+  std::vector<std::vector<int>> batch_residual_blocks;
+  std::vector<const BatchCostFunction*> batch_cost_functions;
+  std::map<BatchKey, int> open_batches;
+  for (int i = 0; i < num_residual_blocks; ++i) {
+    const auto* cost_function = dynamic_cast<const BatchCostFunction*>(
+        residual_blocks[i]->cost_function());
+    if (cost_function == nullptr) {
+      continue;
+    }
+
+    auto [it, inserted] = open_batches.emplace(
+        KeyOf(*residual_blocks[i], *cost_function),
+        static_cast<int>(batch_residual_blocks.size()));
+    if (!inserted) {
+      const int open_batch_size = batch_residual_blocks[it->second].size();
+      if (open_batch_size >= cost_function->max_batch_size()) {
+        it->second = batch_residual_blocks.size();
+        inserted = true;
+      }
+    }
+    if (inserted) {
+      batch_residual_blocks.emplace_back();
+      batch_cost_functions.push_back(cost_function);
+    }
+    batch_residual_blocks[it->second].push_back(i);
+  }
+
+  if (batch_residual_blocks.empty()) {
+    return batches;
+  }
+
+  batches.first_in_batch.resize(num_residual_blocks,
+                                ResidualBlockBatches::kNotBatched);
+  batches.offsets.reserve(batch_residual_blocks.size() + 1);
+  batches.offsets.push_back(0);
+  for (int b = 0; b < batch_residual_blocks.size(); ++b) {
+    const std::vector<int>& batch = batch_residual_blocks[b];
+    for (int i : batch) {
+      batches.first_in_batch[i] = ResidualBlockBatches::kInBatch;
+      batches.residual_blocks.push_back(i);
+      batches.cost_functions.push_back(dynamic_cast<const BatchCostFunction*>(
+          residual_blocks[i]->cost_function()));
+    }
+    batches.first_in_batch[batch[0]] = b;
+    batches.offsets.push_back(batches.residual_blocks.size());
+
+    const BatchCostFunction* cost_function = batch_cost_functions[b];
+    const std::vector<int32_t>& parameter_block_sizes =
+        cost_function->parameter_block_sizes();
+    const int batch_size = batch.size();
+    const int num_parameter_blocks = parameter_block_sizes.size();
+    const int num_parameters = std::accumulate(
+        parameter_block_sizes.begin(), parameter_block_sizes.end(), 0);
+    const int num_residuals = cost_function->num_residuals();
+    batches.max_batch_size = std::max(batches.max_batch_size, batch_size);
+    batches.max_parameter_blocks =
+        std::max(batches.max_parameter_blocks, num_parameter_blocks);
+    batches.max_parameters =
+        std::max(batches.max_parameters, batch_size * num_parameters);
+    batches.max_residuals =
+        std::max(batches.max_residuals, batch_size * num_residuals);
+    batches.max_jacobian_values =
+        std::max(batches.max_jacobian_values,
+                 batch_size * num_residuals * num_parameters);
+  }
+  return batches;
+}
+
+void ResidualBlockBatchEvaluator::Init(const ResidualBlockBatches& batches) {
+  cost_functions_ =
+      std::make_unique<const BatchCostFunction*[]>(batches.max_batch_size);
+  parameters_ = std::make_unique<double[]>(batches.max_parameters);
+  parameter_ptrs_ =
+      std::make_unique<const double*[]>(batches.max_parameter_blocks);
+  residuals_ = std::make_unique<double[]>(batches.max_residuals);
+  jacobians_ = std::make_unique<double[]>(batches.max_jacobian_values);
+  jacobian_ptrs_ = std::make_unique<double*[]>(batches.max_parameter_blocks);
+}
+
+bool ResidualBlockBatchEvaluator::Evaluate(
+    const ResidualBlockBatches& batches,
+    int batch,
+    const std::vector<ResidualBlock*>& residual_blocks,
+    bool compute_jacobians) {
+  const int start = batches.offsets[batch];
+  const int batch_size = batches.batch_size(batch);
+  const int* batch_residual_blocks = batches.residual_blocks.data() + start;
+  const BatchCostFunction* cost_function = batches.cost_functions[start];
+  const ResidualBlock* first_residual_block =
+      residual_blocks[batch_residual_blocks[0]];
+
+  const std::vector<int32_t>& parameter_block_sizes =
+      cost_function->parameter_block_sizes();
+  const int num_parameter_blocks = parameter_block_sizes.size();
+  const int num_residuals = cost_function->num_residuals();
+
+  std::copy_n(
+      batches.cost_functions.data() + start, batch_size, cost_functions_.get());
+
+  // Gather the parameter blocks into the structure of arrays layout. The
+  // requested values are invalidated, so that values the cost function does
+  // not write are detected below.
+  double* parameter_cursor = parameters_.get();
+  double* jacobian_cursor = jacobians_.get();
+  for (int i = 0; i < num_parameter_blocks; ++i) {
+    const int size = parameter_block_sizes[i];
+    for (int k = 0; k < batch_size; ++k) {
+      const double* state = residual_blocks[batch_residual_blocks[k]]
+                                ->parameter_blocks()[i]
+                                ->state();
+      for (int j = 0; j < size; ++j) {
+        parameter_cursor[j * batch_size + k] = state[j];
+      }
+    }
+    parameter_ptrs_[i] = parameter_cursor;
+    parameter_cursor += size * batch_size;
+
+    if (compute_jacobians &&
+        !first_residual_block->parameter_blocks()[i]->IsConstant()) {
+      const int num_jacobian_values = num_residuals * size * batch_size;
+      InvalidateArray(num_jacobian_values, jacobian_cursor);
+      jacobian_ptrs_[i] = jacobian_cursor;
+      jacobian_cursor += num_jacobian_values;
+    } else {
+      jacobian_ptrs_[i] = nullptr;
+    }
+  }
+  InvalidateArray(num_residuals * batch_size, residuals_.get());
+
+  if (!cost_function->EvaluateBatch(
+          batch_size,
+          cost_functions_.get(),
+          parameter_ptrs_.get(),
+          residuals_.get(),
+          compute_jacobians ? jacobian_ptrs_.get() : nullptr)) {
+    return false;
+  }
+
+  // The values of the batch are checked once here, instead of once per
+  // residual block.
+  bool is_valid = IsArrayValid(num_residuals * batch_size, residuals_.get());
+  for (int i = 0; is_valid && i < num_parameter_blocks; ++i) {
+    if (compute_jacobians && jacobian_ptrs_[i] != nullptr) {
+      is_valid = IsArrayValid(
+          num_residuals * parameter_block_sizes[i] * batch_size,
+          jacobian_ptrs_[i]);
+    }
+  }
+  if (!is_valid) {
+    LOG(WARNING) << "\n\nError in evaluating a batch of " << batch_size
+                 << " residual blocks starting with residual block "
+                 << batch_residual_blocks[0]
+                 << ".\n\nEither the BatchCostFunction did not evaluate and "
+                    "fill all residuals and jacobians that were requested or "
+                    "there was a non-finite value (nan/infinite) generated "
+                    "during the residual or jacobian computation.";
+    return false;
+  }
+  return true;
+}
+
+}  // namespace ceres::internal
@@ -0,0 +1,126 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+// Grouping of residual blocks whose cost functions are BatchCostFunctions into
+// batches, and the evaluation of their cost functions one batch at a time.
+
+#ifndef CERES_INTERNAL_RESIDUAL_BLOCK_BATCH_H_
+#define CERES_INTERNAL_RESIDUAL_BLOCK_BATCH_H_
+
+#include <memory>
+#include <vector>
+
+#include "ceres/batch_cost_function.h"
+#include "ceres/internal/disable_warnings.h"
+#include "ceres/internal/export.h"
+
+namespace ceres::internal {
+
+class Program;
+class ResidualBlock;
+
+// A grouping of the residual blocks of a program whose cost functions are
+// BatchCostFunctions into batches. The residual blocks of a batch have cost
+// functions of the same dynamic type, number of residuals and parameter block
+// sizes, the same parameter blocks are constant in all of them, and there are
+// at most max_batch_size() of them. All other residual blocks are not part of
+// any batch and are evaluated one at a time as usual.
+struct CERES_NO_EXPORT ResidualBlockBatches {
+  // Values of first_in_batch for residual blocks that do not start a batch.
+  static constexpr int kNotBatched = -1;
+  static constexpr int kInBatch = -2;
+
+  int num_batches() const { return static_cast<int>(offsets.size()) - 1; }
+  int batch_size(int batch) const {
+    return offsets[batch + 1] - offsets[batch];
+  }
+
+  // For each residual block of the program, the index of the batch it is the
+  // first residual block of, kInBatch if it belongs to a batch but is not its
+  // first residual block, or kNotBatched. Iterating over the residual blocks
+  // in program order and evaluating each batch at its first residual block
+  // visits the batches in program order.
+  std::vector<int> first_in_batch;
+
+  // The residual blocks of batch i are the residual blocks of the program
+  // with indices residual_blocks[offsets[i]], ...,
+  // residual_blocks[offsets[i + 1] - 1], in program order.
+  std::vector<int> offsets;
+  std::vector<int> residual_blocks;
+  // The cost function of residual_blocks[j].
+  std::vector<const BatchCostFunction*> cost_functions;
+
+  // Sizes of the largest batch, used to size the evaluation scratch space.
+  int max_batch_size = 0;
+  int max_parameter_blocks = 0;
+  int max_parameters = 0;
+  int max_residuals = 0;
+  int max_jacobian_values = 0;
+};
+
+// Returns the batches of the residual blocks of program. If none of them has
+// a BatchCostFunction, the returned object is empty, including
+// first_in_batch.
+CERES_NO_EXPORT ResidualBlockBatches
+ComputeResidualBlockBatches(const Program& program);
+
+// Evaluates the cost function of a batch of residual blocks with a single call
+// to BatchCostFunction::EvaluateBatch, into structure of arrays buffers owned
+// by the evaluator, and checks that all the requested values were written and
+// are finite. The results for the individual residual blocks are then written
+// to their destination with ResidualBlock::EvaluateFromBatch. Each thread
+// needs its own ResidualBlockBatchEvaluator.
+class CERES_NO_EXPORT ResidualBlockBatchEvaluator {
+ public:
+  void Init(const ResidualBlockBatches& batches);
+
+  // Evaluates the residual blocks of the given batch. The jacobian of a
+  // parameter block is computed if compute_jacobians is true and the
+  // parameter block is not constant.
+  bool Evaluate(const ResidualBlockBatches& batches,
+                int batch,
+                const std::vector<ResidualBlock*>& residual_blocks,
+                bool compute_jacobians);
+
+  const double* residuals() const { return residuals_.get(); }
+  double const* const* jacobians() const { return jacobian_ptrs_.get(); }
+
+ private:
+  std::unique_ptr<const BatchCostFunction*[]> cost_functions_;
+  std::unique_ptr<double[]> parameters_;
+  std::unique_ptr<const double*[]> parameter_ptrs_;
+  std::unique_ptr<double[]> residuals_;
+  std::unique_ptr<double[]> jacobians_;
+  std::unique_ptr<double*[]> jacobian_ptrs_;
+};
+
+}  // namespace ceres::internal
+
+#include "ceres/internal/reenable_warnings.h"
+
+#endif  // CERES_INTERNAL_RESIDUAL_BLOCK_BATCH_H_
@@ -34,6 +34,7 @@
 #include <string>
 #include <vector>
 
+#include "ceres/block_arena.h"
 #include "ceres/internal/eigen.h"
 #include "ceres/manifold.h"
 #include "ceres/parameter_block.h"
@@ -95,7 +96,13 @@ TEST(ResidualBlock, EvaluateWithNoLossFunctionOrManifolds) {
   TernaryCostFunction cost_function(3, 2, 3, 4);
 
   // Create the object under tests.
-  ResidualBlock residual_block(&cost_function, nullptr, parameters, -1);
+  BlockArena arena;
+  ResidualBlock& residual_block = *ResidualBlock::Create(
+      arena.Allocate(ResidualBlock::MemorySize(parameters.size())),
+      &cost_function,
+      nullptr,
+      parameters.data(),
+      -1);
 
   // Verify getters.
   EXPECT_EQ(&cost_function, residual_block.cost_function());
@@ -232,7 +239,13 @@ TEST(ResidualBlock, EvaluateWithManifolds) {
   LocallyParameterizedCostFunction cost_function;
 
   // Create the object under tests.
-  ResidualBlock residual_block(&cost_function, nullptr, parameters, -1);
+  BlockArena arena;
+  ResidualBlock& residual_block = *ResidualBlock::Create(
+      arena.Allocate(ResidualBlock::MemorySize(parameters.size())),
+      &cost_function,
+      nullptr,
+      parameters.data(),
+      -1);
 
   // Verify getters.
   EXPECT_EQ(&cost_function, residual_block.cost_function());
@@ -34,6 +34,7 @@
 #include <limits>
 #include <memory>
 
+#include "ceres/block_arena.h"
 #include "ceres/cost_function.h"
 #include "ceres/parameter_block.h"
 #include "ceres/residual_block.h"
@@ -51,7 +52,13 @@ static void CheckEvaluation(const CostFunction& cost_function, bool is_good) {
   std::vector<ParameterBlock*> parameter_blocks;
   parameter_blocks.push_back(&parameter_block);
 
-  ResidualBlock residual_block(&cost_function, nullptr, parameter_blocks, -1);
+  BlockArena arena;
+  ResidualBlock& residual_block = *ResidualBlock::Create(
+      arena.Allocate(ResidualBlock::MemorySize(parameter_blocks.size())),
+      &cost_function,
+      nullptr,
+      parameter_blocks.data(),
+      -1);
 
   std::unique_ptr<double[]> scratch(
       new double[residual_block.NumScratchDoublesForEvaluate()]);
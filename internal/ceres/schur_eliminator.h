@@ -31,6 +31,7 @@
 #ifndef CERES_INTERNAL_SCHUR_ELIMINATOR_H_
 #define CERES_INTERNAL_SCHUR_ELIMINATOR_H_
 
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
@@ -227,7 +228,10 @@ template <int kRowBlockSize = Eigen::Dynamic,
 class CERES_NO_EXPORT SchurEliminator final : public SchurEliminatorBase {
  public:
   explicit SchurEliminator(const LinearSolver::Options& options)
-      : num_threads_(options.num_threads), context_(options.context) {
+      : num_threads_(options.num_threads),
+        context_(options.context),
+        use_lock_free_elimination_(options.use_lock_free_schur_elimination &&
+                                   options.num_threads > 1) {
     CHECK(context_ != nullptr);
   }
 
@@ -275,12 +279,60 @@ class CERES_NO_EXPORT SchurEliminator final : public SchurEliminatorBase {
   // buffer_layout[z2] = y1 * z1 + y1 * z5
   using BufferLayoutType = std::map<int, int>;
   struct Chunk {
-    explicit Chunk(int start) : size(0), start(start) {}
+    explicit Chunk(int start) : size(0), start(start), buffer_size(0) {}
     int size;
     int start;
+    // Total size of the E'F products stored according to buffer_layout.
+    int buffer_size;
     BufferLayoutType buffer_layout;
   };
 
+  // Eliminates the chunks in parallel, updating the lhs and rhs blocks
+  // touched by every chunk under the protection of their locks.
+  void EliminateChunks(const BlockSparseMatrixData& A,
+                       const double* b,
+                       const double* D,
+                       BlockRandomAccessMatrix* lhs,
+                       double* rhs);
+
+  // Lock free elimination.
+  //
+  // Instead of having every thread update the lhs and rhs blocks touched by
+  // the chunk it is eliminating, the elimination is split into two passes.
+  //
+  // The first pass runs in parallel over the chunks and stores, for every
+  // chunk, E'F, the inverse of E'E, and the contribution F'(b - E(E'E)^{-1}E'b)
+  // of the chunk to the rhs in a chunk-private region of chunk_storage_.
+  //
+  // The second pass runs in parallel over the f blocks. The block row of the
+  // reduced linear system corresponding to an f block is only updated by the
+  // thread processing that f block, using the stored products of all the
+  // chunks containing the f block. Thus neither pass requires locks.
+  void EliminateChunksLockFree(const BlockSparseMatrixData& A,
+                               const double* b,
+                               const double* D,
+                               BlockRandomAccessMatrix* lhs,
+                               double* rhs);
+
+  // Computes F'(b - E(E'E)^{-1}E'b) for the rows of the chunk, with the
+  // vector for the f block f_block_id being stored at the offset
+  // chunk.buffer_layout[f_block_id] / e_block_size in chunk_rhs.
+  void ChunkRhs(const Chunk& chunk,
+                const BlockSparseMatrixData& A,
+                const double* b,
+                const double* inverse_ete_g,
+                double* chunk_rhs);
+
+  // Adds the contribution of a single chunk to the block row block1 of the
+  // reduced linear system.
+  void ChunkBlockRowUpdate(int thread_id,
+                           const Chunk& chunk,
+                           int block1,
+                           const BlockSparseMatrixData& A,
+                           const double* chunk_storage,
+                           BlockRandomAccessMatrix* lhs,
+                           double* rhs);
+
   void ChunkDiagonalBlockAndGradient(
       const Chunk& chunk,
       const BlockSparseMatrixData& A,
@@ -320,6 +372,7 @@ class CERES_NO_EXPORT SchurEliminator final : public SchurEliminatorBase {
 
   int num_threads_;
   ContextImpl* context_;
+  const bool use_lock_free_elimination_;
   int num_eliminate_blocks_;
   bool assume_full_rank_ete_;
 
@@ -359,6 +412,18 @@ class CERES_NO_EXPORT SchurEliminator final : public SchurEliminatorBase {
   // Locks for the blocks in the right hand side of the reduced linear
   // system.
   std::vector<std::mutex*> rhs_locks_;
+
+  // Storage used by the lock free elimination. The products of chunk i
+  // start at chunk_storage_offsets_[i] in chunk_storage_.
+  std::unique_ptr<double[]> chunk_storage_;
+  std::vector<int64_t> chunk_storage_offsets_;
+  // Chunks containing the f block i (numbered from zero) are stored in
+  // f_block_chunks_[f_block_chunks_offsets_[i], f_block_chunks_offsets_[i+1]).
+  std::vector<int> f_block_chunks_offsets_;
+  std::vector<int> f_block_chunks_;
+  // Partition of the f blocks between the threads with balanced cost of the
+  // block row updates.
+  std::vector<int> f_block_partitions_;
 };
 
 // SchurEliminatorForOneFBlock specializes the SchurEliminatorBase interface for
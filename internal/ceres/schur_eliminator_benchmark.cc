@@ -30,12 +30,16 @@
 
 #include <algorithm>
 #include <memory>
+#include <numeric>
 #include <random>
+#include <set>
+#include <utility>
 #include <vector>
 
 #include "Eigen/Dense"
 #include "benchmark/benchmark.h"
 #include "ceres/block_random_access_dense_matrix.h"
+#include "ceres/block_random_access_sparse_matrix.h"
 #include "ceres/block_sparse_matrix.h"
 #include "ceres/block_structure.h"
 #include "ceres/schur_eliminator.h"
@@ -220,10 +224,141 @@ static void BM_SchurEliminatorForOneFBlockBackSubstitute(
   }
 }
 
+// Bundle adjustment like problem with many f blocks (cameras), each e block
+// (point) being observed by a few cameras from a window of neighbouring
+// cameras, so that the chunks overlap in the reduced linear system.
+class BundleAdjustmentBenchmarkData {
+ public:
+  static constexpr int kNumCameras = 256;
+  static constexpr int kNumPoints = 32768;
+  static constexpr int kObservationsPerPoint = 6;
+  static constexpr int kCameraWindow = 16;
+
+  BundleAdjustmentBenchmarkData() {
+    auto* bs = new CompressedRowBlockStructure;
+    bs->cols.resize(kNumPoints + kNumCameras);
+    int col_pos = 0;
+    for (int i = 0; i < kNumPoints + kNumCameras; ++i) {
+      bs->cols[i].position = col_pos;
+      bs->cols[i].size = i < kNumPoints ? kEBlockSize : kFBlockSize;
+      col_pos += bs->cols[i].size;
+    }
+
+    std::uniform_int_distribution<int> first_camera(
+        0, kNumCameras - kCameraWindow);
+    std::set<std::pair<int, int>> block_pairs;
+    int row_pos = 0;
+    int cell_pos = 0;
+    for (int i = 0; i < kNumPoints; ++i) {
+      std::vector<int> cameras(kCameraWindow);
+      std::iota(cameras.begin(), cameras.end(), first_camera(prng_));
+      std::shuffle(cameras.begin(), cameras.end(), prng_);
+      cameras.resize(kObservationsPerPoint);
+      std::sort(cameras.begin(), cameras.end());
+      for (int j = 0; j < kObservationsPerPoint; ++j) {
+        auto& row = bs->rows.emplace_back();
+        row.block.position = row_pos;
+        row.block.size = kRowBlockSize;
+        row_pos += kRowBlockSize;
+        auto& cells = row.cells;
+        cells.resize(2);
+        cells[0].block_id = i;
+        cells[0].position = cell_pos;
+        cell_pos += kRowBlockSize * kEBlockSize;
+        cells[1].block_id = kNumPoints + cameras[j];
+        cells[1].position = cell_pos;
+        cell_pos += kRowBlockSize * kFBlockSize;
+        for (int k = j; k < kObservationsPerPoint; ++k) {
+          block_pairs.emplace(cameras[j], cameras[k]);
+        }
+      }
+    }
+
+    matrix_ = std::make_unique<BlockSparseMatrix>(bs);
+    double* values = matrix_->mutable_values();
+    std::generate_n(values, matrix_->num_nonzeros(), [this] {
+      return standard_normal_(prng_);
+    });
+
+    b_.resize(matrix_->num_rows());
+    b_.setRandom();
+
+    std::vector<Block> blocks;
+    for (int i = 0; i < kNumCameras; ++i) {
+      blocks.emplace_back(kFBlockSize, i * kFBlockSize);
+    }
+    lhs_ = std::make_unique<BlockRandomAccessSparseMatrix>(
+        blocks, block_pairs, &context_, 1);
+    diagonal_.resize(matrix_->num_cols());
+    diagonal_.setOnes();
+    rhs_.resize(kNumCameras * kFBlockSize);
+  }
+
+  const BlockSparseMatrix& matrix() const { return *matrix_; }
+  const Vector& b() const { return b_; }
+  const Vector& diagonal() const { return diagonal_; }
+  BlockRandomAccessSparseMatrix* mutable_lhs() { return lhs_.get(); }
+  Vector* mutable_rhs() { return &rhs_; }
+
+  ContextImpl* context() { return &context_; }
+
+ private:
+  ContextImpl context_;
+
+  std::unique_ptr<BlockSparseMatrix> matrix_;
+  Vector b_;
+  std::unique_ptr<BlockRandomAccessSparseMatrix> lhs_;
+  Vector rhs_;
+  Vector diagonal_;
+  std::mt19937 prng_;
+  std::normal_distribution<> standard_normal_;
+};
+
+template <bool kUseLockFreeSchurElimination>
+static void BM_SchurEliminatorBundleAdjustment(benchmark::State& state) {
+  const int num_threads = state.range(0);
+  static BundleAdjustmentBenchmarkData data;
+  data.context()->EnsureMinimumThreads(num_threads);
+
+  LinearSolver::Options linear_solver_options;
+  linear_solver_options.e_block_size = kEBlockSize;
+  linear_solver_options.row_block_size = kRowBlockSize;
+  linear_solver_options.f_block_size = kFBlockSize;
+  linear_solver_options.context = data.context();
+  linear_solver_options.num_threads = num_threads;
+  linear_solver_options.use_lock_free_schur_elimination =
+      kUseLockFreeSchurElimination;
+  std::unique_ptr<SchurEliminatorBase> eliminator(
+      SchurEliminatorBase::Create(linear_solver_options));
+
+  eliminator->Init(BundleAdjustmentBenchmarkData::kNumPoints,
+                   true,
+                   data.matrix().block_structure());
+  for (auto _ : state) {
+    eliminator->Eliminate(BlockSparseMatrixData(data.matrix()),
+                          data.b().data(),
+                          data.diagonal().data(),
+                          data.mutable_lhs(),
+                          data.mutable_rhs()->data());
+  }
+}
+
 BENCHMARK(BM_SchurEliminatorEliminate)->Range(10, 10000);
 BENCHMARK(BM_SchurEliminatorForOneFBlockEliminate)->Range(10, 10000);
 BENCHMARK(BM_SchurEliminatorBackSubstitute)->Range(10, 10000);
 BENCHMARK(BM_SchurEliminatorForOneFBlockBackSubstitute)->Range(10, 10000);
+BENCHMARK_TEMPLATE(BM_SchurEliminatorBundleAdjustment, false)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16);
+BENCHMARK_TEMPLATE(BM_SchurEliminatorBundleAdjustment, true)
+    ->Arg(1)
+    ->Arg(2)
+    ->Arg(4)
+    ->Arg(8)
+    ->Arg(16);
 
 }  // namespace ceres::internal
 
@@ -62,6 +62,7 @@
 #include "ceres/invert_psd_matrix.h"
 #include "ceres/map_util.h"
 #include "ceres/parallel_for.h"
+#include "ceres/partition_range_for_parallel_for.h"
 #include "ceres/schur_eliminator.h"
 #include "ceres/scoped_thread_token.h"
 #include "ceres/small_blas.h"
@@ -152,6 +153,7 @@ void SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::Init(
     }
 
     CHECK_GT(chunk.size, 0);  // This check will need to be resolved.
+    chunk.buffer_size = buffer_size;
     r += chunk.size;
   }
   const Chunk& chunk = chunks_.back();
@@ -171,6 +173,67 @@ void SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::Init(
   for (int i = 0; i < num_col_blocks - num_eliminate_blocks_; ++i) {
     rhs_locks_[i] = new std::mutex;
   }
+
+  if (!use_lock_free_elimination_) {
+    return;
+  }
+
+  // Storage for E'F, the rhs contributions and the inverse of E'E of every
+  // chunk.
+  const int num_chunks = chunks_.size();
+  chunk_storage_offsets_.resize(num_chunks + 1);
+  chunk_storage_offsets_[0] = 0;
+  for (int i = 0; i < num_chunks; ++i) {
+    const Chunk& chunk = chunks_[i];
+    const int e_block_id = bs->rows[chunk.start].cells.front().block_id;
+    const int e_block_size = bs->cols[e_block_id].size;
+    chunk_storage_offsets_[i + 1] = chunk_storage_offsets_[i] +
+                                    chunk.buffer_size +
+                                    chunk.buffer_size / e_block_size +
+                                    e_block_size * e_block_size;
+  }
+  chunk_storage_ = std::make_unique<double[]>(chunk_storage_offsets_.back());
+
+  // Invert the chunk to f block incidence and estimate the cost of updating
+  // each block row of the reduced linear system, which is proportional to the
+  // number of cells to the right of the diagonal updated by every chunk.
+  const int num_f_blocks = num_col_blocks - num_eliminate_blocks_;
+  std::vector<int> cumulative_costs(num_f_blocks, 0);
+  f_block_chunks_offsets_.assign(num_f_blocks + 1, 0);
+  for (const Chunk& chunk : chunks_) {
+    int num_cells_to_the_right = chunk.buffer_layout.size();
+    for (const auto& [f_block_id, offset] : chunk.buffer_layout) {
+      const int f_block = f_block_id - num_eliminate_blocks_;
+      ++f_block_chunks_offsets_[f_block + 1];
+      cumulative_costs[f_block] += num_cells_to_the_right--;
+    }
+  }
+  for (int i = 0; i < num_f_blocks; ++i) {
+    f_block_chunks_offsets_[i + 1] += f_block_chunks_offsets_[i];
+    if (i > 0) {
+      cumulative_costs[i] += cumulative_costs[i - 1];
+    }
+  }
+  f_block_chunks_.resize(f_block_chunks_offsets_.back());
+  std::vector<int> f_block_fill(f_block_chunks_offsets_.begin(),
+                                f_block_chunks_offsets_.end() - 1);
+  for (int i = 0; i < num_chunks; ++i) {
+    for (const auto& [f_block_id, offset] : chunks_[i].buffer_layout) {
+      f_block_chunks_[f_block_fill[f_block_id - num_eliminate_blocks_]++] = i;
+    }
+  }
+
+  // Creating several partitions per thread allows to tolerate imperfections of
+  // the cost model.
+  constexpr int kNumPartitionsPerThread = 4;
+  f_block_partitions_ =
+      num_f_blocks > 0 ? PartitionRangeForParallelFor(
+                             0,
+                             num_f_blocks,
+                             num_threads_ * kNumPartitionsPerThread,
+                             cumulative_costs.data(),
+                             [](int cumulative_cost) { return cumulative_cost; })
+                       : std::vector<int>{0};
 }
 
 template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
@@ -225,6 +288,25 @@ void SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::Eliminate(
   // z blocks that share a row block/residual term with the y
   // block. EliminateRowOuterProduct does the corresponding operation
   // for the lhs of the reduced linear system.
+  if (use_lock_free_elimination_) {
+    EliminateChunksLockFree(A, b, D, lhs, rhs);
+  } else {
+    EliminateChunks(A, b, D, lhs, rhs);
+  }
+
+  // For rows with no e_blocks, the Schur complement update reduces to
+  // S += F'F.
+  NoEBlockRowsUpdate(A, b, uneliminated_row_begins_, lhs, rhs);
+}
+
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+void SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::EliminateChunks(
+    const BlockSparseMatrixData& A,
+    const double* b,
+    const double* D,
+    BlockRandomAccessMatrix* lhs,
+    double* rhs) {
+  const CompressedRowBlockStructure* bs = A.block_structure();
   ParallelFor(
       context_,
       0,
@@ -297,10 +379,227 @@ void SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::Eliminate(
         ChunkOuterProduct(
             thread_id, bs, inverse_ete, buffer, chunk.buffer_layout, lhs);
       });
+}
 
-  // For rows with no e_blocks, the Schur complement update reduces to
-  // S += F'F.
-  NoEBlockRowsUpdate(A, b, uneliminated_row_begins_, lhs, rhs);
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+void SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
+    EliminateChunksLockFree(const BlockSparseMatrixData& A,
+                            const double* b,
+                            const double* D,
+                            BlockRandomAccessMatrix* lhs,
+                            double* rhs) {
+  const CompressedRowBlockStructure* bs = A.block_structure();
+
+  // First pass: compute and store E'F, (E'E)^{-1} and the contribution to the
+  // rhs of every chunk.
+  ParallelFor(context_, 0, int(chunks_.size()), num_threads_, [&](int i) {
+    const Chunk& chunk = chunks_[i];
+    const int e_block_id = bs->rows[chunk.start].cells.front().block_id;
+    const int e_block_size = bs->cols[e_block_id].size;
+
+    double* buffer = chunk_storage_.get() + chunk_storage_offsets_[i];
+    double* chunk_rhs = buffer + chunk.buffer_size;
+    double* inverse_ete_ptr = chunk_rhs + chunk.buffer_size / e_block_size;
+
+    VectorRef(buffer, chunk.buffer_size).setZero();
+
+    typename EigenTypes<kEBlockSize, kEBlockSize>::Matrix ete(e_block_size,
+                                                              e_block_size);
+    if (D != nullptr) {
+      const typename EigenTypes<kEBlockSize>::ConstVectorRef diag(
+          D + bs->cols[e_block_id].position, e_block_size);
+      ete = diag.array().square().matrix().asDiagonal();
+    } else {
+      ete.setZero();
+    }
+
+    FixedArray<double, 8> g(e_block_size);
+    typename EigenTypes<kEBlockSize>::VectorRef gref(g.data(), e_block_size);
+    gref.setZero();
+
+    // The F'F terms are added to the lhs in the second pass, hence no lhs is
+    // passed here.
+    ChunkDiagonalBlockAndGradient(
+        chunk, A, b, chunk.start, &ete, g.data(), buffer, nullptr);
+
+    typename EigenTypes<kEBlockSize, kEBlockSize>::MatrixRef inverse_ete(
+        inverse_ete_ptr, e_block_size, e_block_size);
+    inverse_ete = InvertPSDMatrix<kEBlockSize>(assume_full_rank_ete_, ete);
+
+    if (rhs) {
+      FixedArray<double, 8> inverse_ete_g(e_block_size);
+      MatrixVectorMultiply<kEBlockSize, kEBlockSize, 0>(inverse_ete_ptr,
+                                                        e_block_size,
+                                                        e_block_size,
+                                                        g.data(),
+                                                        inverse_ete_g.data());
+      ChunkRhs(chunk, A, b, inverse_ete_g.data(), chunk_rhs);
+    }
+  });
+
+  // Second pass: assemble the block rows of the reduced linear system, each
+  // of them being updated by a single thread.
+  ParallelFor(
+      context_,
+      0,
+      int(f_block_chunks_offsets_.size()) - 1,
+      num_threads_,
+      [&](int thread_id, int block1) {
+        for (int j = f_block_chunks_offsets_[block1];
+             j < f_block_chunks_offsets_[block1 + 1];
+             ++j) {
+          const int chunk_id = f_block_chunks_[j];
+          ChunkBlockRowUpdate(
+              thread_id,
+              chunks_[chunk_id],
+              block1,
+              A,
+              chunk_storage_.get() + chunk_storage_offsets_[chunk_id],
+              lhs,
+              rhs);
+        }
+      },
+      f_block_partitions_);
+}
+
+// Compute F'(b - E(E'E)^{-1}E'b) for the rows of the chunk. This is the
+// contribution of the chunk to the rhs of the reduced linear system computed
+// by UpdateRhs, but stored per f block of the chunk.
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+void SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::ChunkRhs(
+    const Chunk& chunk,
+    const BlockSparseMatrixData& A,
+    const double* b,
+    const double* inverse_ete_g,
+    double* chunk_rhs) {
+  const CompressedRowBlockStructure* bs = A.block_structure();
+  const double* values = A.values();
+
+  const int e_block_id = bs->rows[chunk.start].cells.front().block_id;
+  const int e_block_size = bs->cols[e_block_id].size;
+  VectorRef(chunk_rhs, chunk.buffer_size / e_block_size).setZero();
+
+  int b_pos = bs->rows[chunk.start].block.position;
+  for (int j = 0; j < chunk.size; ++j) {
+    const CompressedRow& row = bs->rows[chunk.start + j];
+    const Cell& e_cell = row.cells.front();
+
+    typename EigenTypes<kRowBlockSize>::Vector sj =
+        typename EigenTypes<kRowBlockSize>::ConstVectorRef(b + b_pos,
+                                                           row.block.size);
+
+    // clang-format off
+    MatrixVectorMultiply<kRowBlockSize, kEBlockSize, -1>(
+        values + e_cell.position, row.block.size, e_block_size,
+        inverse_ete_g, sj.data());
+    // clang-format on
+
+    for (int c = 1; c < row.cells.size(); ++c) {
+      const int block_id = row.cells[c].block_id;
+      const int block_size = bs->cols[block_id].size;
+      double* chunk_rhs_ptr =
+          chunk_rhs + FindOrDie(chunk.buffer_layout, block_id) / e_block_size;
+      // clang-format off
+      MatrixTransposeVectorMultiply<kRowBlockSize, kFBlockSize, 1>(
+          values + row.cells[c].position,
+          row.block.size, block_size,
+          sj.data(), chunk_rhs_ptr);
+      // clang-format on
+    }
+    b_pos += row.block.size;
+  }
+}
+
+// Add the contribution of the chunk to the block row block1 of the reduced
+// linear system, i.e., for all the f blocks block2 >= block1 of the chunk
+//
+//   S(block1, block2) += F_1'F_2 - F_1'E(E'E)^{-1}E'F_2
+//
+// and the corresponding block of the rhs, using the products stored by the
+// first pass of EliminateChunksLockFree.
+template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
+void SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
+    ChunkBlockRowUpdate(int thread_id,
+                        const Chunk& chunk,
+                        int block1,
+                        const BlockSparseMatrixData& A,
+                        const double* chunk_storage,
+                        BlockRandomAccessMatrix* lhs,
+                        double* rhs) {
+  const CompressedRowBlockStructure* bs = A.block_structure();
+  const double* values = A.values();
+
+  const int e_block_id = bs->rows[chunk.start].cells.front().block_id;
+  const int e_block_size = bs->cols[e_block_id].size;
+  const int block1_id = block1 + num_eliminate_blocks_;
+  const int block1_size = bs->cols[block1_id].size;
+
+  const double* buffer = chunk_storage;
+  const double* chunk_rhs = buffer + chunk.buffer_size;
+  const double* inverse_ete = chunk_rhs + chunk.buffer_size / e_block_size;
+
+  // S(block1, block2) += F_1'F_2 for the rows of the chunk.
+  for (int j = 0; j < chunk.size; ++j) {
+    const CompressedRow& row = bs->rows[chunk.start + j];
+    for (int c1 = 1; c1 < row.cells.size(); ++c1) {
+      if (row.cells[c1].block_id != block1_id) {
+        continue;
+      }
+      for (int c2 = c1; c2 < row.cells.size(); ++c2) {
+        const int block2 = row.cells[c2].block_id - num_eliminate_blocks_;
+        int r, c, row_stride, col_stride;
+        CellInfo* cell_info =
+            lhs->GetCell(block1, block2, &r, &c, &row_stride, &col_stride);
+        if (cell_info != nullptr) {
+          const int block2_size = bs->cols[row.cells[c2].block_id].size;
+          // clang-format off
+          MatrixTransposeMatrixMultiply
+              <kRowBlockSize, kFBlockSize, kRowBlockSize, kFBlockSize, 1>(
+              values + row.cells[c1].position, row.block.size, block1_size,
+              values + row.cells[c2].position, row.block.size, block2_size,
+              cell_info->values, r, c, row_stride, col_stride);
+          // clang-format on
+        }
+      }
+      break;
+    }
+  }
+
+  // S(block1, block2) -= F_1'E(E'E)^{-1}E'F_2
+  auto it1 = chunk.buffer_layout.find(block1_id);
+  DCHECK(it1 != chunk.buffer_layout.end());
+  double* b1_transpose_inverse_ete =
+      chunk_outer_product_buffer_.get() + thread_id * buffer_size_;
+  // clang-format off
+  MatrixTransposeMatrixMultiply
+      <kEBlockSize, kFBlockSize, kEBlockSize, kEBlockSize, 0>(
+      buffer + it1->second, e_block_size, block1_size,
+      inverse_ete, e_block_size, e_block_size,
+      b1_transpose_inverse_ete, 0, 0, block1_size, e_block_size);
+  // clang-format on
+  for (auto it2 = it1; it2 != chunk.buffer_layout.end(); ++it2) {
+    const int block2 = it2->first - num_eliminate_blocks_;
+    int r, c, row_stride, col_stride;
+    CellInfo* cell_info =
+        lhs->GetCell(block1, block2, &r, &c, &row_stride, &col_stride);
+    if (cell_info != nullptr) {
+      const int block2_size = bs->cols[it2->first].size;
+      // clang-format off
+      MatrixMatrixMultiply
+          <kFBlockSize, kEBlockSize, kEBlockSize, kFBlockSize, -1>(
+              b1_transpose_inverse_ete, block1_size, e_block_size,
+              buffer  + it2->second, e_block_size, block2_size,
+              cell_info->values, r, c, row_stride, col_stride);
+      // clang-format on
+    }
+  }
+
+  if (rhs) {
+    typename EigenTypes<kFBlockSize>::VectorRef(
+        rhs + lhs_row_layout_[block1], block1_size) +=
+        typename EigenTypes<kFBlockSize>::ConstVectorRef(
+            chunk_rhs + it1->second / e_block_size, block1_size);
+  }
 }
 
 template <int kRowBlockSize, int kEBlockSize, int kFBlockSize>
@@ -462,7 +761,7 @@ void SchurEliminator<kRowBlockSize, kEBlockSize, kFBlockSize>::
   for (int j = 0; j < chunk.size; ++j) {
     const CompressedRow& row = bs->rows[row_block_counter + j];
 
-    if (row.cells.size() > 1) {
+    if (lhs != nullptr && row.cells.size() > 1) {
       EBlockRowOuterProduct(A, row_block_counter + j, lhs);
     }
 
@@ -123,7 +123,9 @@ class SchurEliminatorTest : public ::testing::Test {
 
   void EliminateSolveAndCompare(const VectorRef& diagonal,
                                 bool use_static_structure,
-                                const double relative_tolerance) {
+                                const double relative_tolerance,
+                                int num_threads = 1,
+                                bool use_lock_free_schur_elimination = false) {
     const CompressedRowBlockStructure* bs = A->block_structure();
     const int num_col_blocks = bs->cols.size();
     auto blocks = Tail(bs->cols, num_col_blocks - num_eliminate_blocks);
@@ -136,7 +138,10 @@ class SchurEliminatorTest : public ::testing::Test {
 
     LinearSolver::Options options;
     options.context = &context_;
+    options.num_threads = num_threads;
+    options.use_lock_free_schur_elimination = use_lock_free_schur_elimination;
     options.elimination_groups.push_back(num_eliminate_blocks);
+    context_.EnsureMinimumThreads(num_threads);
     if (use_static_structure) {
       DetectStructure(*bs,
                       num_eliminate_blocks,
@@ -219,6 +224,24 @@ TEST_F(SchurEliminatorTest, VaryingFBlockSizeWithoutStaticStructure) {
   EliminateSolveAndCompare(VectorRef(D.get(), A->num_cols()), false, 1e-14);
 }
 
+TEST_F(SchurEliminatorTest, ScalarProblemLockFreeElimination) {
+  SetUpFromId(2);
+  ComputeReferenceSolution(VectorRef(D.get(), A->num_cols()));
+  EliminateSolveAndCompare(
+      VectorRef(D.get(), A->num_cols()), true, 1e-14, 4, true);
+  EliminateSolveAndCompare(
+      VectorRef(D.get(), A->num_cols()), false, 1e-14, 4, true);
+}
+
+TEST_F(SchurEliminatorTest, VaryingFBlockSizeLockFreeElimination) {
+  SetUpFromId(4);
+  ComputeReferenceSolution(VectorRef(D.get(), A->num_cols()));
+  EliminateSolveAndCompare(
+      VectorRef(D.get(), A->num_cols()), true, 1e-14, 4, true);
+  EliminateSolveAndCompare(
+      VectorRef(D.get(), A->num_cols()), false, 1e-14, 4, true);
+}
+
 TEST(SchurEliminatorForOneFBlock, MatchesSchurEliminator) {
   constexpr int kRowBlockSize = 2;
   constexpr int kEBlockSize = 3;
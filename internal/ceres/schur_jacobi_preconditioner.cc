@@ -76,6 +76,8 @@ void SchurJacobiPreconditioner::InitEliminator(
   eliminator_options.e_block_size = options_.e_block_size;
   eliminator_options.f_block_size = options_.f_block_size;
   eliminator_options.row_block_size = options_.row_block_size;
+  eliminator_options.use_lock_free_schur_elimination =
+      options_.use_lock_free_schur_elimination;
   eliminator_options.context = options_.context;
   eliminator_ = SchurEliminatorBase::Create(eliminator_options);
   const bool kFullRankETE = true;
@@ -37,6 +37,7 @@
 
 #include "ceres/internal/eigen.h"
 #include "ceres/internal/export.h"
+#include "ceres/small_blas_simd.h"
 #include "glog/logging.h"
 #include "small_blas_generic.h"
 
@@ -89,6 +90,22 @@ namespace ceres::internal {
       A, num_row_a, num_col_a,                                          \
       B, num_row_b, num_col_b,                                          \
       C, start_row_c, start_col_c, row_stride_c, col_stride_c);
+
+// Calls the AVX2 kernel and returns if the CPU supports it and the product
+// has at least min_size multiply-adds, see small_blas_simd.h.
+#ifdef CERES_USE_AVX2_SMALL_BLAS
+#define CERES_CALL_AVX2_GEMM(transpose_a, size, min_size)       \
+  if (kCpuHasAvx2Fma && (size) >= (min_size)) {                 \
+    Avx2MatrixMatrixMultiply(kOperation, transpose_a,           \
+                             A, num_row_a, num_col_a,           \
+                             B, num_row_b, num_col_b,           \
+                             C, start_row_c, start_col_c,       \
+                             row_stride_c, col_stride_c);       \
+    return;                                                     \
+  }
+#else
+#define CERES_CALL_AVX2_GEMM(transpose_a, size, min_size)
+#endif
 // clang-format on
 
 #define CERES_GEMM_STORE_SINGLE(p, index, value) \
@@ -253,8 +270,14 @@ CERES_GEMM_BEGIN(MatrixMatrixMultiply) {
 
   if (kRowA != Eigen::Dynamic && kColA != Eigen::Dynamic &&
       kRowB != Eigen::Dynamic && kColB != Eigen::Dynamic) {
+    CERES_CALL_AVX2_GEMM(false,
+                         kRowA * kColA * kColB,
+                         kMinAvx2StaticGemmSize)
     CERES_CALL_GEMM(MatrixMatrixMultiplyEigen)
   } else {
+    CERES_CALL_AVX2_GEMM(false,
+                         num_row_a * num_col_a * num_col_b,
+                         kMinAvx2DynamicGemmSize)
     CERES_CALL_GEMM(MatrixMatrixMultiplyNaive)
   }
 
@@ -360,8 +383,14 @@ CERES_GEMM_BEGIN(MatrixTransposeMatrixMultiply) {
 
   if (kRowA != Eigen::Dynamic && kColA != Eigen::Dynamic &&
       kRowB != Eigen::Dynamic && kColB != Eigen::Dynamic) {
+    CERES_CALL_AVX2_GEMM(true,
+                         kRowA * kColA * kColB,
+                         kMinAvx2StaticGemmSize)
     CERES_CALL_GEMM(MatrixTransposeMatrixMultiplyEigen)
   } else {
+    CERES_CALL_AVX2_GEMM(true,
+                         num_row_a * num_col_a * num_col_b,
+                         kMinAvx2DynamicGemmSize)
     CERES_CALL_GEMM(MatrixTransposeMatrixMultiplyNaive)
   }
 
@@ -382,28 +411,11 @@ CERES_GEMM_BEGIN(MatrixTransposeMatrixMultiply) {
 // kOperation = -1  -> c -= A' * b
 // kOperation =  0  -> c  = A' * b
 template <int kRowA, int kColA, int kOperation>
-inline void MatrixVectorMultiply(const double* A,
-                                 const int num_row_a,
-                                 const int num_col_a,
-                                 const double* b,
-                                 double* c) {
-#ifdef CERES_NO_CUSTOM_BLAS
-  const typename EigenTypes<kRowA, kColA>::ConstMatrixRef Aref(
-      A, num_row_a, num_col_a);
-  const typename EigenTypes<kColA>::ConstVectorRef bref(b, num_col_a);
-  typename EigenTypes<kRowA>::VectorRef cref(c, num_row_a);
-
-  // lazyProduct works better than .noalias() for matrix-vector
-  // products.
-  if (kOperation > 0) {
-    cref += Aref.lazyProduct(bref);
-  } else if (kOperation < 0) {
-    cref -= Aref.lazyProduct(bref);
-  } else {
-    cref = Aref.lazyProduct(bref);
-  }
-#else
-
+inline void MatrixVectorMultiplyNaive(const double* A,
+                                      const int num_row_a,
+                                      const int num_col_a,
+                                      const double* b,
+                                      double* c) {
   DCHECK_GT(num_row_a, 0);
   DCHECK_GT(num_col_a, 0);
   DCHECK((kRowA == Eigen::Dynamic) || (kRowA == num_row_a));
@@ -460,36 +472,55 @@ inline void MatrixVectorMultiply(const double* A,
                &b[0], &c[row], kOperation);
     // clang-format on
   }
-
-#endif  // CERES_NO_CUSTOM_BLAS
 }
 
-// Similar to MatrixVectorMultiply, except that A is transposed, i.e.,
-//
-// c op A' * b;
 template <int kRowA, int kColA, int kOperation>
-inline void MatrixTransposeVectorMultiply(const double* A,
-                                          const int num_row_a,
-                                          const int num_col_a,
-                                          const double* b,
-                                          double* c) {
+inline void MatrixVectorMultiply(const double* A,
+                                 const int num_row_a,
+                                 const int num_col_a,
+                                 const double* b,
+                                 double* c) {
 #ifdef CERES_NO_CUSTOM_BLAS
   const typename EigenTypes<kRowA, kColA>::ConstMatrixRef Aref(
       A, num_row_a, num_col_a);
-  const typename EigenTypes<kRowA>::ConstVectorRef bref(b, num_row_a);
-  typename EigenTypes<kColA>::VectorRef cref(c, num_col_a);
+  const typename EigenTypes<kColA>::ConstVectorRef bref(b, num_col_a);
+  typename EigenTypes<kRowA>::VectorRef cref(c, num_row_a);
 
   // lazyProduct works better than .noalias() for matrix-vector
   // products.
   if (kOperation > 0) {
-    cref += Aref.transpose().lazyProduct(bref);
+    cref += Aref.lazyProduct(bref);
   } else if (kOperation < 0) {
-    cref -= Aref.transpose().lazyProduct(bref);
+    cref -= Aref.lazyProduct(bref);
   } else {
-    cref = Aref.transpose().lazyProduct(bref);
+    cref = Aref.lazyProduct(bref);
   }
 #else
 
+#ifdef CERES_USE_AVX2_SMALL_BLAS
+  const int NUM_ROW_A = (kRowA != Eigen::Dynamic ? kRowA : num_row_a);
+  const int NUM_COL_A = (kColA != Eigen::Dynamic ? kColA : num_col_a);
+  if (kCpuHasAvx2Fma && NUM_ROW_A * NUM_COL_A >= kMinAvx2GemvSize) {
+    Avx2MatrixVectorMultiply(kOperation, false, A, num_row_a, num_col_a, b, c);
+    return;
+  }
+#endif
+
+  MatrixVectorMultiplyNaive<kRowA, kColA, kOperation>(
+      A, num_row_a, num_col_a, b, c);
+
+#endif  // CERES_NO_CUSTOM_BLAS
+}
+
+// Similar to MatrixVectorMultiply, except that A is transposed, i.e.,
+//
+// c op A' * b;
+template <int kRowA, int kColA, int kOperation>
+inline void MatrixTransposeVectorMultiplyNaive(const double* A,
+                                               const int num_row_a,
+                                               const int num_col_a,
+                                               const double* b,
+                                               double* c) {
   DCHECK_GT(num_row_a, 0);
   DCHECK_GT(num_col_a, 0);
   DCHECK((kRowA == Eigen::Dynamic) || (kRowA == num_row_a));
@@ -549,6 +580,42 @@ inline void MatrixTransposeVectorMultiply(const double* A,
                &b[0], &c[row], kOperation);
     // clang-format on
   }
+}
+
+template <int kRowA, int kColA, int kOperation>
+inline void MatrixTransposeVectorMultiply(const double* A,
+                                          const int num_row_a,
+                                          const int num_col_a,
+                                          const double* b,
+                                          double* c) {
+#ifdef CERES_NO_CUSTOM_BLAS
+  const typename EigenTypes<kRowA, kColA>::ConstMatrixRef Aref(
+      A, num_row_a, num_col_a);
+  const typename EigenTypes<kRowA>::ConstVectorRef bref(b, num_row_a);
+  typename EigenTypes<kColA>::VectorRef cref(c, num_col_a);
+
+  // lazyProduct works better than .noalias() for matrix-vector
+  // products.
+  if (kOperation > 0) {
+    cref += Aref.transpose().lazyProduct(bref);
+  } else if (kOperation < 0) {
+    cref -= Aref.transpose().lazyProduct(bref);
+  } else {
+    cref = Aref.transpose().lazyProduct(bref);
+  }
+#else
+
+#ifdef CERES_USE_AVX2_SMALL_BLAS
+  const int NUM_ROW_A = (kRowA != Eigen::Dynamic ? kRowA : num_row_a);
+  const int NUM_COL_A = (kColA != Eigen::Dynamic ? kColA : num_col_a);
+  if (kCpuHasAvx2Fma && NUM_ROW_A * NUM_COL_A >= kMinAvx2GemvSize) {
+    Avx2MatrixVectorMultiply(kOperation, true, A, num_row_a, num_col_a, b, c);
+    return;
+  }
+#endif
+
+  MatrixTransposeVectorMultiplyNaive<kRowA, kColA, kOperation>(
+      A, num_row_a, num_col_a, b, c);
 
 #endif  // CERES_NO_CUSTOM_BLAS
 }
@@ -557,6 +624,7 @@ inline void MatrixTransposeVectorMultiply(const double* A,
 #undef CERES_GEMM_EIGEN_HEADER
 #undef CERES_GEMM_NAIVE_HEADER
 #undef CERES_CALL_GEMM
+#undef CERES_CALL_AVX2_GEMM
 #undef CERES_GEMM_STORE_SINGLE
 #undef CERES_GEMM_STORE_PAIR
 
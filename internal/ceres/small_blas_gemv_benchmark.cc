@@ -94,6 +94,21 @@ static void BM_MatrixVectorMultiply(benchmark::State& state) {
 
 BENCHMARK(BM_MatrixVectorMultiply)->Apply(MatrixSizeArguments);
 
+static void BM_MatrixVectorMultiplyNaive(benchmark::State& state) {
+  const int rows = state.range(0);
+  const int cols = state.range(1);
+  MatrixVectorMultiplyData data(rows, cols);
+  const int num_elements = data.num_elements();
+  int iter = 0;
+  for (auto _ : state) {
+    internal::MatrixVectorMultiplyNaive<Eigen::Dynamic, Eigen::Dynamic, 1>(
+        data.GetB(iter), rows, cols, data.GetC(iter), data.GetA(iter));
+    iter = (iter + 1) % num_elements;
+  }
+}
+
+BENCHMARK(BM_MatrixVectorMultiplyNaive)->Apply(MatrixSizeArguments);
+
 static void BM_MatrixTransposeVectorMultiply(benchmark::State& state) {
   const int rows = state.range(0);
   const int cols = state.range(1);
@@ -109,6 +124,23 @@ static void BM_MatrixTransposeVectorMultiply(benchmark::State& state) {
 
 BENCHMARK(BM_MatrixTransposeVectorMultiply)->Apply(MatrixSizeArguments);
 
+static void BM_MatrixTransposeVectorMultiplyNaive(benchmark::State& state) {
+  const int rows = state.range(0);
+  const int cols = state.range(1);
+  MatrixVectorMultiplyData data(cols, rows);
+  const int num_elements = data.num_elements();
+  int iter = 0;
+  for (auto _ : state) {
+    internal::MatrixTransposeVectorMultiplyNaive<Eigen::Dynamic,
+                                                 Eigen::Dynamic,
+                                                 1>(
+        data.GetB(iter), rows, cols, data.GetC(iter), data.GetA(iter));
+    iter = (iter + 1) % num_elements;
+  }
+}
+
+BENCHMARK(BM_MatrixTransposeVectorMultiplyNaive)->Apply(MatrixSizeArguments);
+
 }  // namespace ceres
 
 BENCHMARK_MAIN();
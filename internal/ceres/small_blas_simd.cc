@@ -0,0 +1,382 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/small_blas_simd.h"
+
+#ifdef CERES_USE_AVX2_SMALL_BLAS
+
+#include <immintrin.h>
+
+namespace ceres::internal {
+
+namespace {
+
+bool CpuHasAvx2Fma() {
+  __builtin_cpu_init();
+  return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+}
+
+// The kernels are compiled for AVX2 and FMA with the target attribute rather
+// than with compiler flags for the whole file, so that no code for these
+// instruction sets ends up in functions the rest of the library shares.
+#define CERES_AVX2 __attribute__((target("avx2,fma")))
+
+// Loads, stores and multiply-adds of 4, 2 and 1 doubles, so that the kernels
+// handle the columns left over after the multiples of four without masks.
+struct Packet4 {
+  static constexpr int kSize = 4;
+  using Type = __m256d;
+  CERES_AVX2 static Type Zero() { return _mm256_setzero_pd(); }
+  CERES_AVX2 static Type Broadcast(double x) { return _mm256_set1_pd(x); }
+  CERES_AVX2 static Type Load(const double* p) { return _mm256_loadu_pd(p); }
+  CERES_AVX2 static void Store(Type x, double* p) { _mm256_storeu_pd(p, x); }
+  CERES_AVX2 static Type Add(Type x, Type y) { return _mm256_add_pd(x, y); }
+  CERES_AVX2 static Type Sub(Type x, Type y) { return _mm256_sub_pd(x, y); }
+  CERES_AVX2 static Type MulAdd(Type x, Type y, Type z) {
+    return _mm256_fmadd_pd(x, y, z);
+  }
+};
+
+struct Packet2 {
+  static constexpr int kSize = 2;
+  using Type = __m128d;
+  CERES_AVX2 static Type Zero() { return _mm_setzero_pd(); }
+  CERES_AVX2 static Type Broadcast(double x) { return _mm_set1_pd(x); }
+  CERES_AVX2 static Type Load(const double* p) { return _mm_loadu_pd(p); }
+  CERES_AVX2 static void Store(Type x, double* p) { _mm_storeu_pd(p, x); }
+  CERES_AVX2 static Type Add(Type x, Type y) { return _mm_add_pd(x, y); }
+  CERES_AVX2 static Type Sub(Type x, Type y) { return _mm_sub_pd(x, y); }
+  CERES_AVX2 static Type MulAdd(Type x, Type y, Type z) {
+    return _mm_fmadd_pd(x, y, z);
+  }
+};
+
+struct Packet1 {
+  static constexpr int kSize = 1;
+  using Type = __m128d;
+  CERES_AVX2 static Type Zero() { return _mm_setzero_pd(); }
+  CERES_AVX2 static Type Broadcast(double x) { return _mm_set_sd(x); }
+  CERES_AVX2 static Type Load(const double* p) { return _mm_load_sd(p); }
+  CERES_AVX2 static void Store(Type x, double* p) { _mm_store_sd(p, x); }
+  CERES_AVX2 static Type Add(Type x, Type y) { return _mm_add_sd(x, y); }
+  CERES_AVX2 static Type Sub(Type x, Type y) { return _mm_sub_sd(x, y); }
+  CERES_AVX2 static Type MulAdd(Type x, Type y, Type z) {
+    return _mm_fmadd_sd(x, y, z);
+  }
+};
+
+template <int kOperation, typename Packet>
+CERES_AVX2 inline void Store(typename Packet::Type x, double* p) {
+  if (kOperation > 0) {
+    x = Packet::Add(Packet::Load(p), x);
+  } else if (kOperation < 0) {
+    x = Packet::Sub(Packet::Load(p), x);
+  }
+  Packet::Store(x, p);
+}
+
+// Computes Packet::kSize columns, starting at col, of kNumRows rows of
+// C op A * B, where entry (i, k) of A is a[i * a_row_stride + k *
+// a_col_stride]. The rows share the loads of B, and their chains of FMAs
+// overlap.
+template <int kOperation, typename Packet, int kNumRows>
+CERES_AVX2 inline void MatrixMatrixMultiplyColumns(const double* a,
+                                                   int a_row_stride,
+                                                   int a_col_stride,
+                                                   const double* B,
+                                                   int num_col_c,
+                                                   int depth,
+                                                   int col,
+                                                   double* c,
+                                                   int c_stride) {
+  typename Packet::Type sums[kNumRows];
+  for (int r = 0; r < kNumRows; ++r) {
+    sums[r] = Packet::Zero();
+  }
+  const double* b = B + col;
+  for (int k = 0; k < depth; ++k, b += num_col_c) {
+    const typename Packet::Type bv = Packet::Load(b);
+    for (int r = 0; r < kNumRows; ++r) {
+      sums[r] = Packet::MulAdd(
+          Packet::Broadcast(a[r * a_row_stride + k * a_col_stride]),
+          bv,
+          sums[r]);
+    }
+  }
+  for (int r = 0; r < kNumRows; ++r) {
+    Store<kOperation, Packet>(sums[r], c + r * c_stride + col);
+  }
+}
+
+template <int kOperation, int kNumRows>
+CERES_AVX2 inline void MatrixMatrixMultiplyRows(const double* a,
+                                                int a_row_stride,
+                                                int a_col_stride,
+                                                const double* B,
+                                                int num_col_c,
+                                                int depth,
+                                                double* c,
+                                                int c_stride) {
+  int col = 0;
+  for (; col + 4 <= num_col_c; col += 4) {
+    MatrixMatrixMultiplyColumns<kOperation, Packet4, kNumRows>(
+        a, a_row_stride, a_col_stride, B, num_col_c, depth, col, c, c_stride);
+  }
+  if (col + 2 <= num_col_c) {
+    MatrixMatrixMultiplyColumns<kOperation, Packet2, kNumRows>(
+        a, a_row_stride, a_col_stride, B, num_col_c, depth, col, c, c_stride);
+    col += 2;
+  }
+  if (col < num_col_c) {
+    MatrixMatrixMultiplyColumns<kOperation, Packet1, kNumRows>(
+        a, a_row_stride, a_col_stride, B, num_col_c, depth, col, c, c_stride);
+  }
+}
+
+// C op A * B, two rows at a time.
+template <int kOperation>
+CERES_AVX2 void MatrixMatrixMultiplyKernel(const double* A,
+                                           int a_row_stride,
+                                           int a_col_stride,
+                                           const double* B,
+                                           int num_row_c,
+                                           int num_col_c,
+                                           int depth,
+                                           double* C,
+                                           int c_stride) {
+  int row = 0;
+  for (; row + 2 <= num_row_c; row += 2) {
+    MatrixMatrixMultiplyRows<kOperation, 2>(A + row * a_row_stride,
+                                            a_row_stride,
+                                            a_col_stride,
+                                            B,
+                                            num_col_c,
+                                            depth,
+                                            C + row * c_stride,
+                                            c_stride);
+  }
+  if (row < num_row_c) {
+    MatrixMatrixMultiplyRows<kOperation, 1>(A + row * a_row_stride,
+                                            a_row_stride,
+                                            a_col_stride,
+                                            B,
+                                            num_col_c,
+                                            depth,
+                                            C + row * c_stride,
+                                            c_stride);
+  }
+}
+
+// Returns [sum(v0), sum(v1), sum(v2), sum(v3)].
+CERES_AVX2 inline __m256d HorizontalSums(__m256d v0,
+                                         __m256d v1,
+                                         __m256d v2,
+                                         __m256d v3) {
+  const __m256d s01 = _mm256_hadd_pd(v0, v1);
+  const __m256d s23 = _mm256_hadd_pd(v2, v3);
+  return _mm256_add_pd(_mm256_permute2f128_pd(s01, s23, 0x20),
+                       _mm256_permute2f128_pd(s01, s23, 0x31));
+}
+
+CERES_AVX2 inline double DotProduct(const double* a, const double* b, int n) {
+  __m256d sum = _mm256_setzero_pd();
+  int i = 0;
+  for (; i + 4 <= n; i += 4) {
+    sum = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), sum);
+  }
+  const __m128d pair = _mm_add_pd(_mm256_castpd256_pd128(sum),
+                                  _mm256_extractf128_pd(sum, 1));
+  double result = _mm_cvtsd_f64(_mm_add_sd(pair, _mm_unpackhi_pd(pair, pair)));
+  for (; i < n; ++i) {
+    result += a[i] * b[i];
+  }
+  return result;
+}
+
+// c op A * b, four rows at a time. The products of each row are accumulated
+// four columns at a time, the four sums are reduced together, and the last
+// columns are added to them with one column of A at a time.
+template <int kOperation>
+CERES_AVX2 void MatrixVectorMultiplyKernel(
+    const double* A, int num_row_a, int num_col_a, const double* b, double* c) {
+  const int num_col_m = num_col_a & ~3;
+  int row = 0;
+  for (; row + 4 <= num_row_a; row += 4) {
+    const double* a0 = A + row * num_col_a;
+    const double* a1 = a0 + num_col_a;
+    const double* a2 = a1 + num_col_a;
+    const double* a3 = a2 + num_col_a;
+    __m256d sum0 = _mm256_setzero_pd();
+    __m256d sum1 = _mm256_setzero_pd();
+    __m256d sum2 = _mm256_setzero_pd();
+    __m256d sum3 = _mm256_setzero_pd();
+    for (int col = 0; col < num_col_m; col += 4) {
+      const __m256d bv = _mm256_loadu_pd(b + col);
+      sum0 = _mm256_fmadd_pd(_mm256_loadu_pd(a0 + col), bv, sum0);
+      sum1 = _mm256_fmadd_pd(_mm256_loadu_pd(a1 + col), bv, sum1);
+      sum2 = _mm256_fmadd_pd(_mm256_loadu_pd(a2 + col), bv, sum2);
+      sum3 = _mm256_fmadd_pd(_mm256_loadu_pd(a3 + col), bv, sum3);
+    }
+    __m256d sums = HorizontalSums(sum0, sum1, sum2, sum3);
+    for (int col = num_col_m; col < num_col_a; ++col) {
+      sums = _mm256_fmadd_pd(
+          _mm256_setr_pd(a0[col], a1[col], a2[col], a3[col]),
+          _mm256_set1_pd(b[col]),
+          sums);
+    }
+    Store<kOperation, Packet4>(sums, c + row);
+  }
+  for (; row < num_row_a; ++row) {
+    const __m128d sum =
+        _mm_set_sd(DotProduct(A + row * num_col_a, b, num_col_a));
+    Store<kOperation, Packet1>(sum, c + row);
+  }
+}
+
+// Computes Packet::kSize entries, starting at col, of c op A' * b.
+template <int kOperation, typename Packet>
+CERES_AVX2 inline void MatrixTransposeVectorColumns(const double* A,
+                                                    int num_row_a,
+                                                    int num_col_a,
+                                                    const double* b,
+                                                    int col,
+                                                    double* c) {
+  typename Packet::Type sum = Packet::Zero();
+  const double* a = A + col;
+  for (int row = 0; row < num_row_a; ++row, a += num_col_a) {
+    sum = Packet::MulAdd(Packet::Broadcast(b[row]), Packet::Load(a), sum);
+  }
+  Store<kOperation, Packet>(sum, c + col);
+}
+
+// c op A' * b, four entries of c at a time.
+template <int kOperation>
+CERES_AVX2 void MatrixTransposeVectorMultiplyKernel(
+    const double* A, int num_row_a, int num_col_a, const double* b, double* c) {
+  int col = 0;
+  for (; col + 4 <= num_col_a; col += 4) {
+    MatrixTransposeVectorColumns<kOperation, Packet4>(
+        A, num_row_a, num_col_a, b, col, c);
+  }
+  if (col + 2 <= num_col_a) {
+    MatrixTransposeVectorColumns<kOperation, Packet2>(
+        A, num_row_a, num_col_a, b, col, c);
+    col += 2;
+  }
+  if (col < num_col_a) {
+    MatrixTransposeVectorColumns<kOperation, Packet1>(
+        A, num_row_a, num_col_a, b, col, c);
+  }
+}
+
+#undef CERES_AVX2
+
+}  // namespace
+
+const bool kCpuHasAvx2Fma = CpuHasAvx2Fma();
+
+void Avx2MatrixMatrixMultiply(int operation,
+                              bool transpose_a,
+                              const double* A,
+                              int num_row_a,
+                              int num_col_a,
+                              const double* B,
+                              int num_row_b,
+                              int num_col_b,
+                              double* C,
+                              int start_row_c,
+                              int start_col_c,
+                              int row_stride_c,
+                              int col_stride_c) {
+  const int num_row_c = transpose_a ? num_col_a : num_row_a;
+  const int a_row_stride = transpose_a ? 1 : num_col_a;
+  const int a_col_stride = transpose_a ? num_col_a : 1;
+  double* c = C + start_row_c * col_stride_c + start_col_c;
+  if (operation > 0) {
+    MatrixMatrixMultiplyKernel<1>(A,
+                                  a_row_stride,
+                                  a_col_stride,
+                                  B,
+                                  num_row_c,
+                                  num_col_b,
+                                  num_row_b,
+                                  c,
+                                  col_stride_c);
+  } else if (operation < 0) {
+    MatrixMatrixMultiplyKernel<-1>(A,
+                                   a_row_stride,
+                                   a_col_stride,
+                                   B,
+                                   num_row_c,
+                                   num_col_b,
+                                   num_row_b,
+                                   c,
+                                   col_stride_c);
+  } else {
+    MatrixMatrixMultiplyKernel<0>(A,
+                                  a_row_stride,
+                                  a_col_stride,
+                                  B,
+                                  num_row_c,
+                                  num_col_b,
+                                  num_row_b,
+                                  c,
+                                  col_stride_c);
+  }
+}
+
+void Avx2MatrixVectorMultiply(int operation,
+                              bool transpose_a,
+                              const double* A,
+                              int num_row_a,
+                              int num_col_a,
+                              const double* b,
+                              double* c) {
+  if (transpose_a) {
+    if (operation > 0) {
+      MatrixTransposeVectorMultiplyKernel<1>(A, num_row_a, num_col_a, b, c);
+    } else if (operation < 0) {
+      MatrixTransposeVectorMultiplyKernel<-1>(A, num_row_a, num_col_a, b, c);
+    } else {
+      MatrixTransposeVectorMultiplyKernel<0>(A, num_row_a, num_col_a, b, c);
+    }
+    return;
+  }
+  if (operation > 0) {
+    MatrixVectorMultiplyKernel<1>(A, num_row_a, num_col_a, b, c);
+  } else if (operation < 0) {
+    MatrixVectorMultiplyKernel<-1>(A, num_row_a, num_col_a, b, c);
+  } else {
+    MatrixVectorMultiplyKernel<0>(A, num_row_a, num_col_a, b, c);
+  }
+}
+
+}  // namespace ceres::internal
+
+#endif  // CERES_USE_AVX2_SMALL_BLAS
@@ -0,0 +1,97 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+//
+// Explicitly vectorized kernels for the functions in small_blas.h. The CPU
+// features they need are detected at runtime, so that a binary built for the
+// baseline of its architecture still uses them on the hosts which have them.
+//
+// Currently there are AVX2 + FMA kernels for x86-64, which process four
+// doubles per instruction, where the baseline SSE2 only processes two. On
+// ARM64 NEON is part of the baseline, so the compiler already vectorizes the
+// generic kernels for it. The blocks in the Schur eliminator are at most a
+// few dozen columns wide, so AVX-512 does not pay for its lower clock speeds
+// and is not used.
+
+#ifndef CERES_INTERNAL_SMALL_BLAS_SIMD_H_
+#define CERES_INTERNAL_SMALL_BLAS_SIMD_H_
+
+#include "ceres/internal/export.h"
+
+#if !defined(CERES_NO_CUSTOM_BLAS) && defined(__x86_64__) && \
+    (defined(__GNUC__) || defined(__clang__))
+#define CERES_USE_AVX2_SMALL_BLAS
+#endif
+
+#ifdef CERES_USE_AVX2_SMALL_BLAS
+
+namespace ceres::internal {
+
+// Whether the CPU supports AVX2 and FMA, determined once at startup.
+extern CERES_NO_EXPORT const bool kCpuHasAvx2Fma;
+
+// The kernels are called out of line, and for the smallest products that
+// costs more than they save. These are the numbers of multiply-adds from
+// which they were measured to be faster on a Xeon with AVX-512 (run with
+// AVX2): for matrix-matrix products, than Eigen's fully unrolled products of
+// fixed size matrices and than the generic loops for dynamic sizes, and for
+// matrix-vector products, than the generic loops for either.
+inline constexpr int kMinAvx2StaticGemmSize = 128;
+inline constexpr int kMinAvx2DynamicGemmSize = 32;
+inline constexpr int kMinAvx2GemvSize = 64;
+
+// The arguments have the same meaning as those of the functions in
+// small_blas.h, and operation is their kOperation. With transpose_a, A' is
+// used in place of A.
+CERES_NO_EXPORT void Avx2MatrixMatrixMultiply(int operation,
+                                              bool transpose_a,
+                                              const double* A,
+                                              int num_row_a,
+                                              int num_col_a,
+                                              const double* B,
+                                              int num_row_b,
+                                              int num_col_b,
+                                              double* C,
+                                              int start_row_c,
+                                              int start_col_c,
+                                              int row_stride_c,
+                                              int col_stride_c);
+
+CERES_NO_EXPORT void Avx2MatrixVectorMultiply(int operation,
+                                              bool transpose_a,
+                                              const double* A,
+                                              int num_row_a,
+                                              int num_col_a,
+                                              const double* b,
+                                              double* c);
+
+}  // namespace ceres::internal
+
+#endif  // CERES_USE_AVX2_SMALL_BLAS
+
+#endif  // CERES_INTERNAL_SMALL_BLAS_SIMD_H_
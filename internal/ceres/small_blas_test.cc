@@ -618,5 +618,109 @@ TEST(BLAS, MatrixTransposeVectorMultiply) {
   }
 }
 
+#ifdef CERES_USE_AVX2_SMALL_BLAS
+
+// The functions above only use the AVX2 kernels for large enough products,
+// so test them directly for all the sizes.
+TEST(BLAS, Avx2MatrixMatrixMultiply) {
+  if (!kCpuHasAvx2Fma) {
+    GTEST_SKIP() << "The CPU does not support AVX2 and FMA.";
+  }
+  for (int m = 1; m < 10; ++m) {
+    for (int k = 1; k < 10; ++k) {
+      for (int n = 1; n < 10; ++n) {
+        for (int operation = -1; operation <= 1; ++operation) {
+          const Matrix A = Matrix::Random(m, k);
+          const Matrix At = A.transpose();
+          const Matrix B = Matrix::Random(k, n);
+          // C is row major, and A * B is written to its block starting at
+          // (1, 2).
+          Matrix C = Matrix::Random(m + 2, n + 3);
+          Matrix C_ref = C;
+          if (operation > 0) {
+            C_ref.block(1, 2, m, n) += A * B;
+          } else if (operation < 0) {
+            C_ref.block(1, 2, m, n) -= A * B;
+          } else {
+            C_ref.block(1, 2, m, n) = A * B;
+          }
+
+          Matrix C_transpose = C;
+          Avx2MatrixMatrixMultiply(operation,
+                                   false,
+                                   A.data(),
+                                   m,
+                                   k,
+                                   B.data(),
+                                   k,
+                                   n,
+                                   C.data(),
+                                   1,
+                                   2,
+                                   m + 2,
+                                   n + 3);
+          Avx2MatrixMatrixMultiply(operation,
+                                   true,
+                                   At.data(),
+                                   k,
+                                   m,
+                                   B.data(),
+                                   k,
+                                   n,
+                                   C_transpose.data(),
+                                   1,
+                                   2,
+                                   m + 2,
+                                   n + 3);
+          EXPECT_NEAR((C_ref - C).norm(), 0.0, 10 * kTolerance)
+              << m << "x" << k << "x" << n << " " << operation;
+          EXPECT_NEAR((C_ref - C_transpose).norm(), 0.0, 10 * kTolerance)
+              << m << "x" << k << "x" << n << " " << operation;
+        }
+      }
+    }
+  }
+}
+
+TEST(BLAS, Avx2MatrixVectorMultiply) {
+  if (!kCpuHasAvx2Fma) {
+    GTEST_SKIP() << "The CPU does not support AVX2 and FMA.";
+  }
+  for (int m = 1; m < 10; ++m) {
+    for (int n = 1; n < 10; ++n) {
+      for (int operation = -1; operation <= 1; ++operation) {
+        const Matrix A = Matrix::Random(m, n);
+        const Vector b = Vector::Random(n);
+        const Vector bt = Vector::Random(m);
+        Vector c = Vector::Random(m);
+        Vector ct = Vector::Random(n);
+        Vector c_ref = c;
+        Vector ct_ref = ct;
+        if (operation > 0) {
+          c_ref += A * b;
+          ct_ref += A.transpose() * bt;
+        } else if (operation < 0) {
+          c_ref -= A * b;
+          ct_ref -= A.transpose() * bt;
+        } else {
+          c_ref = A * b;
+          ct_ref = A.transpose() * bt;
+        }
+
+        Avx2MatrixVectorMultiply(
+            operation, false, A.data(), m, n, b.data(), c.data());
+        Avx2MatrixVectorMultiply(
+            operation, true, A.data(), m, n, bt.data(), ct.data());
+        EXPECT_NEAR((c_ref - c).norm(), 0.0, 10 * kTolerance)
+            << m << "x" << n << " " << operation;
+        EXPECT_NEAR((ct_ref - ct).norm(), 0.0, 10 * kTolerance)
+            << m << "x" << n << " " << operation;
+      }
+    }
+  }
+}
+
+#endif  // CERES_USE_AVX2_SMALL_BLAS
+
 }  // namespace internal
 }  // namespace ceres
@@ -51,6 +51,7 @@
 #include "ceres/problem_impl.h"
 #include "ceres/program.h"
 #include "ceres/schur_templates.h"
+#include "ceres/solver_plan_impl.h"
 #include "ceres/solver_utils.h"
 #include "ceres/stringprintf.h"
 #include "ceres/suitesparse.h"
@@ -562,6 +563,23 @@ void PreSolveSummarize(const Solver::Options& options,
   // clang-format on
 }
 
+// Returns the statistics named name accumulated since
+// initial_statistics were recorded. The two are different only if the
+// object reporting them is reused across calls to Solve.
+internal::CallStatistics StatisticsSince(
+    const std::map<std::string, internal::CallStatistics>& statistics,
+    const std::map<std::string, internal::CallStatistics>& initial_statistics,
+    const std::string& name) {
+  using internal::CallStatistics;
+  CallStatistics call_stats =
+      FindWithDefault(statistics, name, CallStatistics());
+  const CallStatistics initial_call_stats =
+      FindWithDefault(initial_statistics, name, CallStatistics());
+  call_stats.time -= initial_call_stats.time;
+  call_stats.calls -= initial_call_stats.calls;
+  return call_stats;
+}
+
 void PostSolveSummarize(const internal::PreprocessedProblem& pp,
                         Solver::Summary* summary) {
   internal::OrderingToGroupSizes(pp.options.linear_solver_ordering.get(),
@@ -596,15 +614,19 @@ void PostSolveSummarize(const internal::PreprocessedProblem& pp,
     const std::map<std::string, CallStatistics>& evaluator_statistics =
         pp.evaluator->Statistics();
     {
-      const CallStatistics& call_stats = FindWithDefault(
-          evaluator_statistics, "Evaluator::Residual", CallStatistics());
+      const CallStatistics call_stats =
+          StatisticsSince(evaluator_statistics,
+                          pp.initial_evaluator_statistics,
+                          "Evaluator::Residual");
 
       summary->residual_evaluation_time_in_seconds = call_stats.time;
       summary->num_residual_evaluations = call_stats.calls;
     }
     {
-      const CallStatistics& call_stats = FindWithDefault(
-          evaluator_statistics, "Evaluator::Jacobian", CallStatistics());
+      const CallStatistics call_stats =
+          StatisticsSince(evaluator_statistics,
+                          pp.initial_evaluator_statistics,
+                          "Evaluator::Jacobian");
 
       summary->jacobian_evaluation_time_in_seconds = call_stats.time;
       summary->num_jacobian_evaluations = call_stats.calls;
@@ -617,8 +639,10 @@ void PostSolveSummarize(const internal::PreprocessedProblem& pp,
   if (pp.linear_solver != nullptr) {
     const std::map<std::string, CallStatistics>& linear_solver_statistics =
         pp.linear_solver->Statistics();
-    const CallStatistics& call_stats = FindWithDefault(
-        linear_solver_statistics, "LinearSolver::Solve", CallStatistics());
+    const CallStatistics call_stats =
+        StatisticsSince(linear_solver_statistics,
+                        pp.initial_linear_solver_statistics,
+                        "LinearSolver::Solve");
     summary->num_linear_solves = call_stats.calls;
     summary->linear_solver_time_in_seconds = call_stats.time;
   }
@@ -763,17 +787,24 @@ void Solver::Solve(const Solver::Options& options,
   // The main thread also does work so we only need to launch num_threads - 1.
   problem_impl->context()->EnsureMinimumThreads(options.num_threads - 1);
 
-  auto preprocessor = Preprocessor::Create(modified_options.minimizer_type);
-  PreprocessedProblem pp;
-
-  const bool status =
-      preprocessor->Preprocess(modified_options, problem_impl, &pp);
+  // The gradient checking problem is recreated by every call to Solve,
+  // so it cannot be used with a SolverPlan.
+  PreprocessedProblem local_pp;
+  PreprocessedProblem* pp = &local_pp;
+  bool status = false;
+  if (options.solver_plan != nullptr && !options.check_gradients) {
+    status = options.solver_plan->mutable_impl()->Preprocess(
+        modified_options, problem_impl, &pp);
+  } else {
+    auto preprocessor = Preprocessor::Create(modified_options.minimizer_type);
+    status = preprocessor->Preprocess(modified_options, problem_impl, pp);
+  }
 
   // We check the linear_solver_options.type rather than
   // modified_options.linear_solver_type because, depending on the
   // lack of a Schur structure, the preprocessor may change the linear
   // solver type.
-  if (status && IsSchurType(pp.linear_solver_options.type)) {
+  if (status && IsSchurType(pp->linear_solver_options.type)) {
     // TODO(sameeragarwal): We can likely eliminate the duplicate call
     // to DetectStructure here and inside the linear solver, by
     // calling this in the preprocessor.
@@ -781,9 +812,9 @@ void Solver::Solve(const Solver::Options& options,
     int e_block_size;
     int f_block_size;
     DetectStructure(*static_cast<internal::BlockSparseMatrix*>(
-                         pp.minimizer_options.jacobian.get())
+                         pp->minimizer_options.jacobian.get())
                          ->block_structure(),
-                    pp.linear_solver_options.elimination_groups[0],
+                    pp->linear_solver_options.elimination_groups[0],
                     &row_block_size,
                     &e_block_size,
                     &f_block_size);
@@ -795,16 +826,16 @@ void Solver::Solve(const Solver::Options& options,
         SchurStructureToString(row_block_size, e_block_size, f_block_size);
   }
 
-  summary->fixed_cost = pp.fixed_cost;
+  summary->fixed_cost = pp->fixed_cost;
   summary->preprocessor_time_in_seconds = WallTimeInSeconds() - start_time;
 
   if (status) {
     const double minimizer_start_time = WallTimeInSeconds();
-    Minimize(&pp, summary);
+    Minimize(pp, summary);
     summary->minimizer_time_in_seconds =
         WallTimeInSeconds() - minimizer_start_time;
   } else {
-    summary->message = pp.error;
+    summary->message = pp->error;
   }
 
   const double postprocessor_start_time = WallTimeInSeconds();
@@ -815,7 +846,7 @@ void Solver::Solve(const Solver::Options& options,
   // to their position in the original user provided program.
   program->SetParameterBlockStatePtrsToUserStatePtrs();
   program->SetParameterOffsetsAndIndex();
-  PostSolveSummarize(pp, summary);
+  PostSolveSummarize(*pp, summary);
   summary->postprocessor_time_in_seconds =
       WallTimeInSeconds() - postprocessor_start_time;
 
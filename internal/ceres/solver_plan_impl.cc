@@ -0,0 +1,149 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#include "ceres/solver_plan_impl.h"
+
+#include <memory>
+
+#include "ceres/ordered_groups.h"
+#include "ceres/preprocessor.h"
+#include "ceres/problem_impl.h"
+#include "ceres/solver.h"
+
+namespace ceres::internal {
+
+namespace {
+
+// Returns true if a and b are both null, or contain the same groups.
+bool AreEqual(const std::shared_ptr<ParameterBlockOrdering>& a,
+              const std::shared_ptr<ParameterBlockOrdering>& b) {
+  if (a == nullptr || b == nullptr) {
+    return a == b;
+  }
+  return a->group_to_elements() == b->group_to_elements();
+}
+
+std::shared_ptr<ParameterBlockOrdering> Copy(
+    const std::shared_ptr<ParameterBlockOrdering>& ordering) {
+  if (ordering == nullptr) {
+    return nullptr;
+  }
+  return std::make_shared<ParameterBlockOrdering>(*ordering);
+}
+
+// Returns true if a PreprocessedProblem computed using options a can
+// be reused with options b, i.e., if the options which determine the
+// reduced program, its ordering, the linear solver and the evaluator
+// are the same.
+bool AreStructurallyEquivalent(const Solver::Options& a,
+                               const Solver::Options& b) {
+  // clang-format off
+  return a.minimizer_type == b.minimizer_type &&
+         a.linear_solver_type == b.linear_solver_type &&
+         a.preconditioner_type == b.preconditioner_type &&
+         a.visibility_clustering_type == b.visibility_clustering_type &&
+         a.residual_blocks_for_subset_preconditioner ==
+             b.residual_blocks_for_subset_preconditioner &&
+         a.dense_linear_algebra_library_type ==
+             b.dense_linear_algebra_library_type &&
+         a.sparse_linear_algebra_library_type ==
+             b.sparse_linear_algebra_library_type &&
+         a.linear_solver_ordering_type == b.linear_solver_ordering_type &&
+         AreEqual(a.linear_solver_ordering, b.linear_solver_ordering) &&
+         a.use_explicit_schur_complement == b.use_explicit_schur_complement &&
+         a.use_lock_free_schur_elimination ==
+             b.use_lock_free_schur_elimination &&
+         a.dynamic_sparsity == b.dynamic_sparsity &&
+         a.use_mixed_precision_solves == b.use_mixed_precision_solves &&
+         a.max_num_refinement_iterations == b.max_num_refinement_iterations &&
+         a.min_linear_solver_iterations == b.min_linear_solver_iterations &&
+         a.max_linear_solver_iterations == b.max_linear_solver_iterations &&
+         a.use_spse_initialization == b.use_spse_initialization &&
+         a.spse_tolerance == b.spse_tolerance &&
+         a.max_num_spse_iterations == b.max_num_spse_iterations &&
+         a.use_inner_iterations == b.use_inner_iterations &&
+         AreEqual(a.inner_iteration_ordering, b.inner_iteration_ordering) &&
+         a.num_threads == b.num_threads;
+  // clang-format on
+}
+
+}  // namespace
+
+bool SolverPlanImpl::CanReuse(const Solver::Options& options,
+                              const ProblemImpl& problem) const {
+  // Structure versions are unique across problems, so a matching
+  // version also guarantees that pp_ refers to this problem.
+  return pp_ != nullptr &&
+         structure_version_ == problem.structure_version() &&
+         AreStructurallyEquivalent(options_, options);
+}
+
+bool SolverPlanImpl::Preprocess(const Solver::Options& options,
+                                ProblemImpl* problem,
+                                PreprocessedProblem** pp) {
+  CHECK(problem != nullptr);
+  CHECK(pp != nullptr);
+  auto preprocessor = Preprocessor::Create(options.minimizer_type);
+  reused_ = CanReuse(options, *problem);
+  if (reused_) {
+    *pp = pp_.get();
+    if (pp_->evaluator != nullptr) {
+      pp_->initial_evaluator_statistics = pp_->evaluator->Statistics();
+    }
+    if (pp_->linear_solver != nullptr) {
+      pp_->initial_linear_solver_statistics = pp_->linear_solver->Statistics();
+    }
+    return preprocessor->Rebind(options, pp_.get());
+  }
+
+  pp_ = std::make_unique<PreprocessedProblem>();
+  *pp = pp_.get();
+  if (!preprocessor->Preprocess(options, problem, pp_.get())) {
+    structure_version_ = -1;
+    return false;
+  }
+
+  // The orderings belong to the user, who may modify them between
+  // calls to Solve, so the plan keeps copies of them. These are taken
+  // after preprocessing, since the preprocessor may update an ordering
+  // supplied by the user.
+  options_ = options;
+  options_.linear_solver_ordering = Copy(options.linear_solver_ordering);
+  options_.inner_iteration_ordering = Copy(options.inner_iteration_ordering);
+  structure_version_ = problem->structure_version();
+  return true;
+}
+
+void SolverPlanImpl::Reset() {
+  pp_ = nullptr;
+  structure_version_ = -1;
+  reused_ = false;
+}
+
+}  // namespace ceres::internal
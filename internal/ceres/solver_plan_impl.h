@@ -0,0 +1,81 @@
+// Ceres Solver - A fast non-linear least squares minimizer
+// Copyright 2023 Google Inc. All rights reserved.
+// http://ceres-solver.org/
+//
+// Redistribution and use in source and binary forms, with or without
+// modification, are permitted provided that the following conditions are met:
+//
+// * Redistributions of source code must retain the above copyright notice,
+//   this list of conditions and the following disclaimer.
+// * Redistributions in binary form must reproduce the above copyright notice,
+//   this list of conditions and the following disclaimer in the documentation
+//   and/or other materials provided with the distribution.
+// * Neither the name of Google Inc. nor the names of its contributors may be
+//   used to endorse or promote products derived from this software without
+//   specific prior written permission.
+//
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+// AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+// IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE
+// ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR CONTRIBUTORS BE
+// LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+// CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF
+// SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS
+// INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN
+// CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE)
+// ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+// POSSIBILITY OF SUCH DAMAGE.
+//
+
+#ifndef CERES_INTERNAL_SOLVER_PLAN_IMPL_H_
+#define CERES_INTERNAL_SOLVER_PLAN_IMPL_H_
+
+#include <cstdint>
+#include <memory>
+
+#include "ceres/internal/disable_warnings.h"
+#include "ceres/internal/export.h"
+#include "ceres/preprocessor.h"
+#include "ceres/problem_impl.h"
+#include "ceres/solver.h"
+
+namespace ceres::internal {
+
+// Owns the PreprocessedProblem computed by the last call to Solve
+// which used the SolverPlan, along with the problem structure and the
+// options it was computed for.
+class CERES_NO_EXPORT SolverPlanImpl {
+ public:
+  // Preprocess the problem, reusing the stored PreprocessedProblem if
+  // it was computed for the same problem structure and compatible
+  // options, and return it in pp. The returned PreprocessedProblem is
+  // owned by the SolverPlanImpl and is valid until the next call to
+  // Preprocess or Reset.
+  bool Preprocess(const Solver::Options& options,
+                  ProblemImpl* problem,
+                  PreprocessedProblem** pp);
+
+  void Reset();
+
+  // True if the last call to Preprocess reused the stored
+  // PreprocessedProblem.
+  bool reused() const { return reused_; }
+
+ private:
+  bool CanReuse(const Solver::Options& options,
+                const ProblemImpl& problem) const;
+
+  std::unique_ptr<PreprocessedProblem> pp_;
+  // The options passed to Solve when pp_ was computed.
+  Solver::Options options_;
+  // Structure version of the problem pp_ was computed for, or -1 if
+  // pp_ cannot be reused.
+  int64_t structure_version_ = -1;
+  bool reused_ = false;
+};
+
+}  // namespace ceres::internal
+
+#include "ceres/internal/reenable_warnings.h"
+
+#endif  // CERES_INTERNAL_SOLVER_PLAN_IMPL_H_
@@ -42,6 +42,8 @@
 #include "ceres/problem.h"
 #include "ceres/problem_impl.h"
 #include "ceres/sized_cost_function.h"
+#include "ceres/solver_plan.h"
+#include "ceres/solver_plan_impl.h"
 #include "gtest/gtest.h"
 
 namespace ceres::internal {
@@ -1226,4 +1228,123 @@ TEST(Solver, LargeCostProblem) {
   EXPECT_EQ(summary.termination_type, FAILURE);
 }
 
+TEST(Solver, SolverPlanIsReusedForUnchangedStructure) {
+  double x = 1.0;
+  double y = 2.0;
+  double z = 3.0;
+  Problem problem;
+  problem.AddResidualBlock(LinearCostFunction::Create(), nullptr, &x, &y);
+  problem.AddResidualBlock(QuadraticCostFunctor::Create(), nullptr, &z);
+  problem.SetParameterBlockConstant(&z);
+
+  SolverPlan plan;
+  Solver::Options options;
+  options.linear_solver_type = DENSE_SCHUR;
+  options.solver_plan = &plan;
+  Solver::Summary summary;
+  Solve(options, &problem, &summary);
+  EXPECT_FALSE(plan.mutable_impl()->reused());
+  EXPECT_TRUE(summary.IsSolutionUsable());
+  EXPECT_NEAR(x, 10.0, 1e-6);
+  EXPECT_NEAR(y, 5.0, 1e-6);
+  EXPECT_EQ(summary.fixed_cost, 2.0);
+  const int num_linear_solves = summary.num_linear_solves;
+
+  // Only the values of the parameter blocks and the options which do
+  // not affect the structure of the problem change.
+  x = -1.0;
+  y = -2.0;
+  z = 9.0;
+  options.max_num_iterations = 10;
+  Solve(options, &problem, &summary);
+  EXPECT_TRUE(plan.mutable_impl()->reused());
+  EXPECT_TRUE(summary.IsSolutionUsable());
+  EXPECT_NEAR(x, 10.0, 1e-6);
+  EXPECT_NEAR(y, 5.0, 1e-6);
+  EXPECT_EQ(summary.fixed_cost, 8.0);
+  EXPECT_EQ(summary.num_linear_solves, num_linear_solves);
+  EXPECT_EQ(summary.linear_solver_type_used, DENSE_SCHUR);
+}
+
+TEST(Solver, SolverPlanIsNotReusedForChangedStructure) {
+  double x = 1.0;
+  double y = 2.0;
+  Problem problem;
+  problem.AddResidualBlock(LinearCostFunction::Create(), nullptr, &x, &y);
+
+  SolverPlan plan;
+  Solver::Options options;
+  options.linear_solver_type = DENSE_QR;
+  options.solver_plan = &plan;
+  Solver::Summary summary;
+  Solve(options, &problem, &summary);
+  EXPECT_FALSE(plan.mutable_impl()->reused());
+
+  // Setting an already variable parameter block variable does not
+  // change the structure.
+  problem.SetParameterBlockVariable(&y);
+  Solve(options, &problem, &summary);
+  EXPECT_TRUE(plan.mutable_impl()->reused());
+
+  y = 2.0;
+  problem.SetParameterBlockConstant(&y);
+  Solve(options, &problem, &summary);
+  EXPECT_FALSE(plan.mutable_impl()->reused());
+  EXPECT_TRUE(summary.IsSolutionUsable());
+  EXPECT_NEAR(x, 10.0, 1e-6);
+  EXPECT_EQ(y, 2.0);
+  EXPECT_EQ(summary.num_effective_parameters_reduced, 1);
+
+  options.linear_solver_type = DENSE_NORMAL_CHOLESKY;
+  Solve(options, &problem, &summary);
+  EXPECT_FALSE(plan.mutable_impl()->reused());
+  EXPECT_EQ(summary.linear_solver_type_used, DENSE_NORMAL_CHOLESKY);
+
+  // A different problem with the same structure does not reuse the plan.
+  Problem other_problem;
+  other_problem.AddResidualBlock(
+      LinearCostFunction::Create(), nullptr, &x, &y);
+  other_problem.SetParameterBlockConstant(&y);
+  Solve(options, &other_problem, &summary);
+  EXPECT_FALSE(plan.mutable_impl()->reused());
+
+  plan.Reset();
+  Solve(options, &other_problem, &summary);
+  EXPECT_FALSE(plan.mutable_impl()->reused());
+  EXPECT_TRUE(summary.IsSolutionUsable());
+}
+
+TEST(Solver, SolverPlanComparesOrderingsByContent) {
+  double x = 1.0;
+  double y = 2.0;
+  Problem problem;
+  problem.AddResidualBlock(LinearCostFunction::Create(), nullptr, &x, &y);
+
+  SolverPlan plan;
+  Solver::Options options;
+  options.linear_solver_type = DENSE_SCHUR;
+  options.solver_plan = &plan;
+  options.linear_solver_ordering = std::make_shared<ParameterBlockOrdering>();
+  options.linear_solver_ordering->AddElementToGroup(&x, 0);
+  options.linear_solver_ordering->AddElementToGroup(&y, 1);
+  Solver::Summary summary;
+  Solve(options, &problem, &summary);
+  EXPECT_FALSE(plan.mutable_impl()->reused());
+
+  // An equal copy of the ordering does not invalidate the plan.
+  options.linear_solver_ordering =
+      std::make_shared<ParameterBlockOrdering>(*options.linear_solver_ordering);
+  Solve(options, &problem, &summary);
+  EXPECT_TRUE(plan.mutable_impl()->reused());
+
+  // Modifying the ordering in place does.
+  options.linear_solver_ordering->AddElementToGroup(&x, 1);
+  options.linear_solver_ordering->AddElementToGroup(&y, 0);
+  Solve(options, &problem, &summary);
+  EXPECT_FALSE(plan.mutable_impl()->reused());
+  EXPECT_TRUE(summary.IsSolutionUsable());
+  Solve(options, &problem, &summary);
+  EXPECT_TRUE(plan.mutable_impl()->reused());
+}
+
 }  // namespace ceres::internal
@@ -30,10 +30,21 @@
 
 #include "ceres/thread_pool.h"
 
+#include <algorithm>
+#include <cctype>
 #include <cmath>
 #include <limits>
+#include <string>
+#include <utility>
 
 #include "ceres/internal/config.h"
+#include "glog/logging.h"
+
+#if defined(__linux__)
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#endif  // defined(__linux__)
 
 namespace ceres::internal {
 namespace {
@@ -43,8 +54,115 @@ int GetNumAllowedThreads(int requested_num_threads) {
   return std::min(requested_num_threads, ThreadPool::MaxNumThreadsAvailable());
 }
 
+// Upper bound on the number of workers if the number of hardware threads is
+// unknown.
+constexpr int kMaxNumWorkersIfUnknown = 1024;
+
+// Identity of the worker executing on the current thread, used to push tasks
+// added from within tasks to the queue of the worker.
+thread_local const ThreadPool* current_thread_pool = nullptr;
+thread_local int current_worker_id = -1;
+
+#if defined(__linux__)
+// Returns the NUMA node of the cpu, which is exposed by the kernel as a nodeN
+// entry in the sysfs directory of the cpu.  Returns 0 if it is not available.
+int NumaNodeOfCpu(int cpu) {
+  const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+  DIR* directory = opendir(path.c_str());
+  if (directory == nullptr) {
+    return 0;
+  }
+  int node = 0;
+  while (dirent* entry = readdir(directory)) {
+    const std::string name = entry->d_name;
+    if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+        std::isdigit(static_cast<unsigned char>(name[4]))) {
+      node = std::stoi(name.substr(4));
+      break;
+    }
+  }
+  closedir(directory);
+  return node;
+}
+
+// Returns the cpus available to the process ordered by their NUMA node.
+std::vector<int> CpusInNumaOrder() {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  if (sched_getaffinity(0, sizeof(cpu_set), &cpu_set) != 0) {
+    LOG(WARNING) << "Unable to query the cpu affinity of the process, threads "
+                    "will not be pinned.";
+    return {};
+  }
+  std::vector<std::pair<int, int>> nodes_and_cpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &cpu_set)) {
+      nodes_and_cpus.emplace_back(NumaNodeOfCpu(cpu), cpu);
+    }
+  }
+  std::sort(nodes_and_cpus.begin(), nodes_and_cpus.end());
+  std::vector<int> cpus;
+  for (const auto& [node, cpu] : nodes_and_cpus) {
+    cpus.push_back(cpu);
+  }
+  return cpus;
+}
+
+void PinCurrentThreadToCpu(int cpu) {
+  cpu_set_t cpu_set;
+  CPU_ZERO(&cpu_set);
+  CPU_SET(cpu, &cpu_set);
+  if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0) {
+    LOG(WARNING) << "Unable to pin thread to cpu " << cpu;
+  }
+}
+#else
+std::vector<int> CpusInNumaOrder() {
+  LOG(WARNING) << "Thread pinning is not supported on this platform.";
+  return {};
+}
+
+void PinCurrentThreadToCpu(int cpu) {}
+#endif  // defined(__linux__)
+
 }  // namespace
 
+void ThreadPool::TaskDeque::PushBack(ThreadPoolTask&& task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (size_ == buffer_.size()) {
+    // Grow the ring buffer, unrolling it so that the head is at index 0.
+    std::vector<ThreadPoolTask> buffer(std::max<std::size_t>(16, 2 * size_));
+    for (std::size_t i = 0; i < size_; ++i) {
+      buffer[i] = std::move(buffer_[(head_ + i) % buffer_.size()]);
+    }
+    buffer_.swap(buffer);
+    head_ = 0;
+  }
+  buffer_[(head_ + size_) % buffer_.size()] = std::move(task);
+  ++size_;
+}
+
+bool ThreadPool::TaskDeque::PopBack(ThreadPoolTask* task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (size_ == 0) {
+    return false;
+  }
+  --size_;
+  *task = std::move(buffer_[(head_ + size_) % buffer_.size()]);
+  return true;
+}
+
+bool ThreadPool::TaskDeque::PopFront(ThreadPoolTask* task) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (size_ == 0) {
+    return false;
+  }
+  *task = std::move(buffer_[head_]);
+  head_ = (head_ + 1) % buffer_.size();
+  --size_;
+  return true;
+}
+
 int ThreadPool::MaxNumThreadsAvailable() {
   const int num_hardware_threads = std::thread::hardware_concurrency();
   // hardware_concurrency() can return 0 if the value is not well defined or not
@@ -53,9 +171,11 @@ int ThreadPool::MaxNumThreadsAvailable() {
                                    : num_hardware_threads;
 }
 
-ThreadPool::ThreadPool() = default;
+ThreadPool::ThreadPool()
+    : max_num_workers_(GetNumAllowedThreads(kMaxNumWorkersIfUnknown)),
+      worker_queues_(std::make_unique<TaskDeque[]>(max_num_workers_)) {}
 
-ThreadPool::ThreadPool(int num_threads) { Resize(num_threads); }
+ThreadPool::ThreadPool(int num_threads) : ThreadPool() { Resize(num_threads); }
 
 ThreadPool::~ThreadPool() {
   std::lock_guard<std::mutex> lock(thread_pool_mutex_);
@@ -76,15 +196,41 @@ void ThreadPool::Resize(int num_threads) {
   }
 
   const int create_num_threads =
-      GetNumAllowedThreads(num_threads) - num_current_threads;
+      std::min(GetNumAllowedThreads(num_threads), max_num_workers_) -
+      num_current_threads;
 
   for (int i = 0; i < create_num_threads; ++i) {
-    thread_pool_.emplace_back(&ThreadPool::ThreadMainLoop, this);
+    const int worker_id = num_current_threads + i;
+    // The first cpu is left to the thread which invokes ParallelFor.
+    const int cpu = cpus_.empty() ? -1 : cpus_[(worker_id + 1) % cpus_.size()];
+    num_workers_.store(worker_id + 1);
+    thread_pool_.emplace_back(
+        &ThreadPool::ThreadMainLoop, this, worker_id, cpu);
   }
 }
 
-void ThreadPool::AddTask(const std::function<void()>& func) {
-  task_queue_.Push(func);
+void ThreadPool::SetThreadPinning(bool pin_threads) {
+  std::lock_guard<std::mutex> lock(thread_pool_mutex_);
+  cpus_.clear();
+  if (pin_threads) {
+    cpus_ = CpusInNumaOrder();
+  }
+}
+
+void ThreadPool::Enqueue(ThreadPoolTask&& task) {
+  if (current_thread_pool == this) {
+    worker_queues_[current_worker_id].PushBack(std::move(task));
+  } else {
+    injection_queue_.PushBack(std::move(task));
+  }
+  num_queued_tasks_.fetch_add(1);
+  // The sleeping worker increments num_sleeping_workers_ before checking
+  // num_queued_tasks_, hence either the worker observes the new task or we
+  // observe the sleeping worker and wake it up.
+  if (num_sleeping_workers_.load() > 0) {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    wake_up_condition_.notify_one();
+  }
 }
 
 int ThreadPool::Size() {
@@ -92,13 +238,57 @@ int ThreadPool::Size() {
   return thread_pool_.size();
 }
 
-void ThreadPool::ThreadMainLoop() {
-  std::function<void()> task;
-  while (task_queue_.Wait(&task)) {
-    task();
+bool ThreadPool::FindTask(int worker_id, ThreadPoolTask* task) {
+  bool found = worker_queues_[worker_id].PopBack(task) ||
+               injection_queue_.PopFront(task);
+  const int num_workers = num_workers_.load();
+  for (int i = 1; !found && i < num_workers; ++i) {
+    found = worker_queues_[(worker_id + i) % num_workers].PopFront(task);
+  }
+  if (found) {
+    num_queued_tasks_.fetch_sub(1);
+  }
+  return found;
+}
+
+void ThreadPool::ThreadMainLoop(int worker_id, int cpu) {
+  if (cpu >= 0) {
+    PinCurrentThreadToCpu(cpu);
   }
+  current_thread_pool = this;
+  current_worker_id = worker_id;
+
+  ThreadPoolTask task;
+  while (true) {
+    if (FindTask(worker_id, &task)) {
+      task();
+      // Destroy the callable before looking for the next task.
+      task = ThreadPoolTask();
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+    num_sleeping_workers_.fetch_add(1);
+    wake_up_condition_.wait(
+        lock, [this]() { return stop_ || num_queued_tasks_.load() > 0; });
+    num_sleeping_workers_.fetch_sub(1);
+    if (num_queued_tasks_.load() > 0) {
+      // A task is either available or is about to be taken by another worker.
+      continue;
+    }
+    if (stop_) {
+      break;
+    }
+  }
+
+  current_thread_pool = nullptr;
+  current_worker_id = -1;
 }
 
-void ThreadPool::Stop() { task_queue_.StopWaiters(); }
+void ThreadPool::Stop() {
+  std::lock_guard<std::mutex> lock(sleep_mutex_);
+  stop_ = true;
+  wake_up_condition_.notify_all();
+}
 
 }  // namespace ceres::internal
@@ -31,20 +31,110 @@
 #ifndef CERES_INTERNAL_THREAD_POOL_H_
 #define CERES_INTERNAL_THREAD_POOL_H_
 
-#include <functional>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
 #include <mutex>
+#include <new>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-#include "ceres/concurrent_queue.h"
 #include "ceres/internal/export.h"
 
 namespace ceres::internal {
 
-// A thread-safe thread pool with an unbounded task queue and a resizable number
-// of workers.  The size of the thread pool can be increased but never decreased
-// in order to support the largest number of threads requested.  The ThreadPool
-// has three states:
+// A type-erased, move-only void() callable with fixed-size inline storage.
+// Tasks never allocate: a callable that does not fit into kStorageSize bytes is
+// rejected at compile time.  The ParallelFor machinery only enqueues small
+// closures holding a few pointers, so this allows the thread pool to schedule
+// work without touching the heap.
+class CERES_NO_EXPORT ThreadPoolTask {
+ public:
+  static constexpr std::size_t kStorageSize = 64;
+
+  ThreadPoolTask() = default;
+
+  template <typename F,
+            typename T = std::decay_t<F>,
+            typename = std::enable_if_t<!std::is_same_v<T, ThreadPoolTask>>>
+  explicit ThreadPoolTask(F&& function) {
+    static_assert(sizeof(T) <= kStorageSize,
+                  "Callable is too large to be stored inline in a "
+                  "ThreadPoolTask.");
+    static_assert(alignof(T) <= alignof(std::max_align_t),
+                  "Callable is over-aligned.");
+    static_assert(std::is_nothrow_move_constructible_v<T>,
+                  "Callable must be nothrow move constructible.");
+    new (storage_) T(std::forward<F>(function));
+    invoke_ = [](void* storage) { (*static_cast<T*>(storage))(); };
+    relocate_ = [](void* destination, void* source) {
+      T* source_function = static_cast<T*>(source);
+      if (destination != nullptr) {
+        new (destination) T(std::move(*source_function));
+      }
+      source_function->~T();
+    };
+  }
+
+  // Moving a task transfers its callable. The moved-from task is left empty,
+  // exactly like a default constructed one: it converts to false, must not be
+  // invoked, and may be destroyed or assigned to.
+  ThreadPoolTask(ThreadPoolTask&& other) noexcept { MoveFrom(other); }
+
+  ThreadPoolTask& operator=(ThreadPoolTask&& other) noexcept {
+    if (this != &other) {
+      Reset();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  ThreadPoolTask(const ThreadPoolTask&) = delete;
+  ThreadPoolTask& operator=(const ThreadPoolTask&) = delete;
+
+  ~ThreadPoolTask() { Reset(); }
+
+  // Invokes the callable. The task must not be empty.
+  void operator()() { invoke_(storage_); }
+
+  // Returns false if the task is empty, i.e., default constructed or moved
+  // from.
+  explicit operator bool() const { return invoke_ != nullptr; }
+
+ private:
+  void Reset() {
+    if (relocate_ != nullptr) {
+      relocate_(nullptr, storage_);
+    }
+    invoke_ = nullptr;
+    relocate_ = nullptr;
+  }
+
+  void MoveFrom(ThreadPoolTask& other) {
+    if (other.relocate_ == nullptr) {
+      return;
+    }
+    other.relocate_(storage_, other.storage_);
+    invoke_ = other.invoke_;
+    relocate_ = other.relocate_;
+    other.invoke_ = nullptr;
+    other.relocate_ = nullptr;
+  }
+
+  alignas(std::max_align_t) std::byte storage_[kStorageSize];
+  void (*invoke_)(void*) = nullptr;
+  // Move-constructs the callable into destination (if it is not null) and
+  // destroys the source.
+  void (*relocate_)(void* destination, void* source) = nullptr;
+};
+
+// A thread-safe, work-stealing thread pool with unbounded task queues and a
+// resizable number of workers.  The size of the thread pool can be increased
+// but never decreased in order to support the largest number of threads
+// requested.  The ThreadPool has three states:
 //
 //  (1) The thread pool size is zero.  Tasks may be added to the thread pool via
 //  AddTask but they will not be executed until the thread pool is resized.
@@ -57,6 +147,14 @@ namespace ceres::internal {
 //  workers to stop.  The workers will finish all of the tasks that have already
 //  been added to the thread pool.
 //
+// Every worker owns a double-ended task queue.  Tasks added by a worker (e.g.
+// the tasks that ParallelFor spawns from within its own tasks) are pushed to
+// the back of the worker's own queue, and the worker takes tasks from the back
+// of its queue.  Tasks added from outside of the thread pool go into a shared
+// injection queue.  An idle worker first drains its own queue, then the
+// injection queue, and then steals from the front of the queues of the other
+// workers.  Since every queue has its own lock, workers of a large pool do not
+// contend on a single mutex.
 class CERES_NO_EXPORT ThreadPool {
  public:
   // Returns the maximum number of hardware threads.
@@ -93,24 +191,73 @@ class CERES_NO_EXPORT ThreadPool {
   // idle thread or when a thread becomes available.  If the thread pool has no
   // threads, then the task will never be executed and the user should use
   // Resize() to create a non-empty thread pool.
-  void AddTask(const std::function<void()>& func);
+  //
+  // The callable is stored inline in a ThreadPoolTask, so adding a task does
+  // not allocate memory once the task queues have grown to their working size.
+  template <typename F>
+  void AddTask(F&& func) {
+    Enqueue(ThreadPoolTask(std::forward<F>(func)));
+  }
 
   // Returns the current size of the thread pool.
   int Size();
 
+  // If enabled, every worker started afterwards is pinned to a single CPU, with
+  // CPUs being assigned in the order of their NUMA nodes.  The first CPU is
+  // left to the thread calling ParallelFor.  This is a no-op on platforms other
+  // than Linux.  Should be called before the thread pool is resized.
+  void SetThreadPinning(bool pin_threads);
+
  private:
-  // Main loop for the threads which blocks on the task queue until work becomes
-  // available.  It will return if and only if Stop has been called.
-  void ThreadMainLoop();
+  // A double-ended queue of tasks implemented as a growable ring buffer.
+  class TaskDeque {
+   public:
+    void PushBack(ThreadPoolTask&& task);
+    bool PopBack(ThreadPoolTask* task);
+    bool PopFront(ThreadPoolTask* task);
+
+   private:
+    std::mutex mutex_;
+    std::vector<ThreadPoolTask> buffer_;
+    std::size_t head_ = 0;
+    std::size_t size_ = 0;
+  };
+
+  void Enqueue(ThreadPoolTask&& task);
+
+  // Tries to find a task for the worker, first in its own queue, then in the
+  // injection queue, and finally in the queues of the other workers.
+  bool FindTask(int worker_id, ThreadPoolTask* task);
+
+  // Main loop for the threads which executes tasks while there are any and
+  // blocks otherwise.  It will return if and only if Stop has been called and
+  // there is no more work left.  If cpu is non-negative, the thread pins itself
+  // to it first.
+  void ThreadMainLoop(int worker_id, int cpu);
 
   // Signal all the threads to stop.  It does not block until the threads are
   // finished.
   void Stop();
 
-  // The queue that stores the units of work available for the thread pool.  The
-  // task queue maintains its own thread safety.
-  ConcurrentQueue<std::function<void()>> task_queue_;
+  // Maximal number of workers; per-worker queues are allocated upfront so that
+  // they can be accessed without synchronization while the pool is resized.
+  const int max_num_workers_;
+  std::unique_ptr<TaskDeque[]> worker_queues_;
+  // Number of workers whose queue may be stolen from.
+  std::atomic<int> num_workers_{0};
+  TaskDeque injection_queue_;
+
+  // Number of tasks which were added to the queues but not yet taken from
+  // them.  Used to put idle workers to sleep.
+  std::atomic<int> num_queued_tasks_{0};
+  std::atomic<int> num_sleeping_workers_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_up_condition_;
+  bool stop_ = false;
+
   std::vector<std::thread> thread_pool_;
+  // CPUs to pin the workers to, empty if thread pinning is disabled.
+  std::vector<int> cpus_;
   std::mutex thread_pool_mutex_;
 };
 
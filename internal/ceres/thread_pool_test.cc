@@ -30,16 +30,26 @@
 
 #include "ceres/thread_pool.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
 #include <condition_variable>
+#include <functional>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 #include "ceres/internal/config.h"
 #include "glog/logging.h"
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif  // defined(__linux__)
+
 namespace ceres::internal {
 
 // Adds a number of tasks to the thread pool and ensures they all run.
@@ -166,6 +176,101 @@ TEST(ThreadPool, Destructor) {
   EXPECT_EQ(100, value);
 }
 
+// Adds tasks from within the tasks executed by the thread pool.  These are
+// pushed to the queue of the worker and can be stolen by the idle workers.  The
+// destructor has to wait for all of them to finish.
+TEST(ThreadPool, AddTaskFromWorker) {
+  const int num_tasks = 1000;
+  std::atomic<int> value = 0;
+  std::function<void(int)> spawn;
+  {
+    ThreadPool thread_pool(/*num_threads=*/4);
+    spawn = [&](int depth) {
+      if (depth + 1 < num_tasks) {
+        thread_pool.AddTask([&spawn, depth]() { spawn(depth + 1); });
+      }
+      ++value;
+    };
+    thread_pool.AddTask([&spawn]() { spawn(0); });
+  }
+
+  EXPECT_EQ(num_tasks, value);
+}
+
+#if defined(__linux__)
+// Every worker of a pool with thread pinning enabled runs on a single cpu.
+TEST(ThreadPool, ThreadPinning) {
+  constexpr int kNumThreads = 2;
+  cpu_set_t process_cpus;
+  CPU_ZERO(&process_cpus);
+  ASSERT_EQ(sched_getaffinity(0, sizeof(process_cpus), &process_cpus), 0);
+  // The first cpu is left to the thread calling ParallelFor.
+  if (CPU_COUNT(&process_cpus) < kNumThreads + 1) {
+    GTEST_SKIP() << "Not enough cpus to pin " << kNumThreads << " threads.";
+  }
+
+  const int num_tasks = 100;
+  std::mutex mutex;
+  std::vector<int> pinned_cpus;
+  int num_unpinned_tasks = 0;
+  {
+    ThreadPool thread_pool;
+    thread_pool.SetThreadPinning(true);
+    thread_pool.Resize(kNumThreads);
+    for (int i = 0; i < num_tasks; ++i) {
+      thread_pool.AddTask([&]() {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        const bool has_affinity =
+            pthread_getaffinity_np(pthread_self(), sizeof(cpus), &cpus) == 0;
+        const int cpu = sched_getcpu();
+        std::lock_guard<std::mutex> lock(mutex);
+        if (has_affinity && CPU_COUNT(&cpus) == 1 && CPU_ISSET(cpu, &cpus)) {
+          pinned_cpus.push_back(cpu);
+        } else {
+          ++num_unpinned_tasks;
+        }
+      });
+    }
+  }
+
+  EXPECT_EQ(num_unpinned_tasks, 0);
+  EXPECT_EQ(static_cast<int>(pinned_cpus.size()), num_tasks);
+  // Since every worker stays on its cpu, the tasks ran on at most one cpu per
+  // worker, all of them available to the process.
+  std::sort(pinned_cpus.begin(), pinned_cpus.end());
+  pinned_cpus.erase(std::unique(pinned_cpus.begin(), pinned_cpus.end()),
+                    pinned_cpus.end());
+  EXPECT_LE(static_cast<int>(pinned_cpus.size()), kNumThreads);
+  for (int cpu : pinned_cpus) {
+    EXPECT_TRUE(CPU_ISSET(cpu, &process_cpus));
+  }
+}
+#endif  // defined(__linux__)
+
+// Tasks own the callables stored inline and destroy them exactly once.
+TEST(ThreadPoolTask, MoveAndDestroy) {
+  auto counter = std::make_shared<int>(0);
+  {
+    ThreadPoolTask task([counter]() { ++*counter; });
+    EXPECT_EQ(counter.use_count(), 2);
+    ThreadPoolTask moved_task(std::move(task));
+    // A moved-from task is documented to be empty.
+    EXPECT_FALSE(task);  // NOLINT(bugprone-use-after-move)
+    EXPECT_TRUE(moved_task);
+    EXPECT_EQ(counter.use_count(), 2);
+    moved_task();
+    EXPECT_EQ(*counter, 1);
+
+    // An empty task can be assigned to.
+    task = std::move(moved_task);
+    EXPECT_TRUE(task);
+    EXPECT_FALSE(moved_task);  // NOLINT(bugprone-use-after-move)
+    EXPECT_EQ(counter.use_count(), 2);
+  }
+  EXPECT_EQ(counter.use_count(), 1);
+}
+
 TEST(ThreadPool, Resize) {
   // Ensure the hardware supports more than 1 thread to ensure the test will
   // pass.
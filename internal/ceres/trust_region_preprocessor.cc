@@ -30,8 +30,10 @@
 
 #include "ceres/trust_region_preprocessor.h"
 
+#include <memory>
 #include <numeric>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include "ceres/callbacks.h"
@@ -213,6 +215,8 @@ bool SetupLinearSolver(PreprocessedProblem* pp) {
       options.dense_linear_algebra_library_type;
   pp->linear_solver_options.use_explicit_schur_complement =
       options.use_explicit_schur_complement;
+  pp->linear_solver_options.use_lock_free_schur_elimination =
+      options.use_lock_free_schur_elimination;
   pp->linear_solver_options.dynamic_sparsity = options.dynamic_sparsity;
   pp->linear_solver_options.use_mixed_precision_solves =
       options.use_mixed_precision_solves;
@@ -339,10 +343,18 @@ bool SetupInnerIterationMinimizer(PreprocessedProblem* pp) {
 bool SetupMinimizerOptions(PreprocessedProblem* pp) {
   const Solver::Options& options = pp->options;
 
+  // When a PreprocessedProblem is rebound, the Jacobian and the trust
+  // region strategy created by the first call are reused.
+  std::shared_ptr<SparseMatrix> jacobian =
+      std::move(pp->minimizer_options.jacobian);
+  std::shared_ptr<TrustRegionStrategy> trust_region_strategy =
+      std::move(pp->minimizer_options.trust_region_strategy);
   SetupCommonMinimizerOptions(pp);
   pp->minimizer_options.is_constrained =
       pp->reduced_program->IsBoundsConstrained();
-  pp->minimizer_options.jacobian = pp->evaluator->CreateJacobian();
+  pp->minimizer_options.jacobian =
+      jacobian != nullptr ? std::move(jacobian)
+                          : pp->evaluator->CreateJacobian();
   if (pp->minimizer_options.jacobian == nullptr) {
     pp->error =
         "Unable to create Jacobian matrix. Likely because it is too large.";
@@ -363,8 +375,14 @@ bool SetupMinimizerOptions(PreprocessedProblem* pp) {
   strategy_options.dogleg_type = options.dogleg_type;
   strategy_options.context = pp->problem->context();
   strategy_options.num_threads = options.num_threads;
-  pp->minimizer_options.trust_region_strategy =
-      TrustRegionStrategy::Create(strategy_options);
+  if (trust_region_strategy != nullptr &&
+      trust_region_strategy->Reset(strategy_options)) {
+    pp->minimizer_options.trust_region_strategy =
+        std::move(trust_region_strategy);
+  } else {
+    pp->minimizer_options.trust_region_strategy =
+        TrustRegionStrategy::Create(strategy_options);
+  }
   CHECK(pp->minimizer_options.trust_region_strategy != nullptr);
   return true;
 }
@@ -405,4 +423,19 @@ bool TrustRegionPreprocessor::Preprocess(const Solver::Options& options,
   return SetupMinimizerOptions(pp);
 }
 
+bool TrustRegionPreprocessor::Rebind(const Solver::Options& options,
+                                     PreprocessedProblem* pp) {
+  CHECK(pp != nullptr);
+  if (!IsProgramValid(pp->problem->program(), &pp->error) ||
+      !RebindCommon(options, pp)) {
+    return false;
+  }
+
+  if (pp->reduced_program->NumParameterBlocks() == 0) {
+    return true;
+  }
+
+  return SetupMinimizerOptions(pp);
+}
+
 }  // namespace ceres::internal
@@ -42,6 +42,8 @@ class CERES_NO_EXPORT TrustRegionPreprocessor final : public Preprocessor {
   bool Preprocess(const Solver::Options& options,
                   ProblemImpl* problem,
                   PreprocessedProblem* preprocessed_problem) override;
+  bool Rebind(const Solver::Options& options,
+              PreprocessedProblem* preprocessed_problem) override;
 };
 
 }  // namespace ceres::internal
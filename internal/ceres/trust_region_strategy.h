@@ -142,6 +142,14 @@ class CERES_NO_EXPORT TrustRegionStrategy {
 
   // Current trust region radius.
   virtual double Radius() const = 0;
+
+  // Return the strategy to the state of a newly created one, but keep
+  // the memory it allocated, so that it can be reused for solving the
+  // same problem again. options must use the same linear solver,
+  // context and number of threads as the options used to create the
+  // strategy. Returns false, leaving the strategy unchanged, if
+  // options asks for a different type of strategy.
+  virtual bool Reset(const Options& options) = 0;
 };
 
 }  // namespace ceres::internal